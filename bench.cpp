@@ -0,0 +1,213 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "common.hpp"
+#include "board.hpp"
+#include "boardNode.hpp"
+#include "transTable.hpp"
+#include "endgameSolver.hpp"
+#include "probCut.hpp"
+#include "linearHeuristic.hpp"
+#include "timeHeuristic.hpp"
+#include "patternHeuristic.hpp"
+
+#define DEFAULT_DEPTH 9
+#define DEFAULT_WEIGHTS "weights/handmade.weights"
+#define MIDGAME_FILE "positions/midgame.txt"
+#define ENDGAME_FILE "positions/endgame.pos"
+#define BENCH_T_TABLE_ENTRIES (1 << 20)
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+    Board board;
+    bool side;
+} BenchPosition;
+
+/**
+ * Reads midgame positions, one per line in Board::setBoard format followed by
+ * the side to move, b or w
+ */
+static vector<BenchPosition> readMidgame(const char* filename){
+    vector<BenchPosition> positions;
+    ifstream ifile(filename);
+    string data, side;
+    while(ifile >> data >> side){
+        BenchPosition p;
+        p.board.setBoard(&data[0]);
+        p.side = side == "b" ? BLACK : WHITE;
+        positions.push_back(p);
+    }
+    return positions;
+}
+
+/**
+ * Reads endgame positions in the FFO test set format: a line of 64 squares
+ * with X for black, O for white and - for empty, then a line saying
+ * "Black to move" or "White to move"
+ */
+static vector<BenchPosition> readEndgame(const char* filename){
+    vector<BenchPosition> positions;
+    ifstream ifile(filename);
+    string squares, line;
+    while(getline(ifile, squares) && getline(ifile, line)){
+        char data[64];
+        for(int i = 0; i < 64; i++){
+            data[i] = squares[i] == 'X' ? 'b' : squares[i] == 'O' ? 'w' : '-';
+        }
+        BenchPosition p;
+        p.board.setBoard(data);
+        p.side = line.compare(0, 5, "Black") == 0 ? BLACK : WHITE;
+        positions.push_back(p);
+    }
+    return positions;
+}
+
+/**
+ * Folds a value into a running FNV-1a hash, one byte at a time
+ */
+static unsigned long long fold(unsigned long long hash, unsigned long long value){
+    for(int i = 0; i < 8; i++){
+        hash = (hash ^ ((value >> (8 * i)) & 0xff)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Writes a move as a JSON value
+ */
+static string moveJson(Move m){
+    if(m.isNull()){
+        return "null";
+    }
+    return "[" + to_string(m.getX()) + "," + to_string(m.getY()) + "]";
+}
+
+/**
+ * Searches each midgame position to a fixed depth with a fresh table, printing
+ * one JSON line per position
+ */
+template<class H>
+static void runMidgame(vector<BenchPosition>& midgame, int depth, H* heuristic,
+        ProbCut* probCut, unsigned long long* signature, long long* totalNodes,
+        double* totalSeconds){
+    for(int i = 0; i < (int)midgame.size(); i++){
+        TransTable tTable(BENCH_T_TABLE_ENTRIES);
+        BoardNode root(&midgame[i].board, midgame[i].side);
+        root.setProbCut(probCut);
+        auto start = chrono::steady_clock::now();
+        Move best = root.getBestChoice(depth, heuristic, &tTable);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        long long nodes = root.getNodeCount();
+        double hitRate = root.getTTProbes() ?
+                    (double)root.getTTHits() / root.getTTProbes() : 0;
+        cout << "{\"suite\":\"midgame\",\"id\":" << i + 1
+             << ",\"depth\":" << root.getDepthReached()
+             << ",\"nodes\":" << nodes
+             << ",\"ms\":" << seconds * 1000
+             << ",\"nps\":" << (long long)(nodes / max(seconds, 1e-9))
+             << ",\"ttHitRate\":" << hitRate
+             << ",\"move\":" << moveJson(best) << "}" << endl;
+
+        *signature = fold(fold(*signature, nodes), best.getData());
+        *totalNodes += nodes;
+        *totalSeconds += seconds;
+    }
+}
+
+// Searches a fixed set of positions and prints one JSON line per position and
+// a summary line. The signature only depends on node counts and best moves,
+// so it changes exactly when the search does. The search is full width
+// unless "selective" follows the weights and they have Multi-ProbCut
+// parameters.
+// The endgame positions are solved on the number of threads given last; node
+// counts of a parallel solve vary from run to run, and so does the signature.
+// Usage: bench [depth] [weights] [full|selective] [threads]
+int main(int argc, char *argv[]) {
+    int depth = argc > 1 ? atoi(argv[1]) : DEFAULT_DEPTH;
+    const char* weightName = argc > 2 ? argv[2] : DEFAULT_WEIGHTS;
+    bool isSelective = argc > 3 && string(argv[3]) == "selective";
+    int numThreads = argc > 4 ? atoi(argv[4]) : 1;
+
+    ifstream ifile(weightName);
+    string heuristicType;
+    if(!(ifile >> heuristicType)){
+        cerr << "Error opening file: " << weightName << endl;
+        return 1;
+    }
+    ifile.close();
+
+    // Multi-ProbCut parameters fitted for the weights are used if the search
+    // is asked to be selective
+    string probCutName(weightName);
+    probCutName = probCutName.substr(0, probCutName.rfind('.')) + ".probcut";
+    ProbCut parameters;
+    ProbCut* probCut = nullptr;
+    if(isSelective && parameters.load(probCutName.c_str())){
+        probCut = &parameters;
+    }
+
+    vector<BenchPosition> midgame = readMidgame(MIDGAME_FILE);
+    vector<BenchPosition> endgame = readEndgame(ENDGAME_FILE);
+    if(midgame.empty() || endgame.empty()){
+        cerr << "Error reading " << MIDGAME_FILE << " or " << ENDGAME_FILE << endl;
+        return 1;
+    }
+
+    unsigned long long signature = FNV_OFFSET;
+    long long totalNodes = 0;
+    double totalSeconds = 0;
+    cout << fixed << setprecision(3);
+
+    if(heuristicType == "time"){
+        TimeHeuristic heuristic(weightName);
+        runMidgame(midgame, depth, &heuristic, probCut, &signature, &totalNodes, &totalSeconds);
+    }
+    else if(heuristicType == "pattern"){
+        PatternHeuristic heuristic(weightName);
+        runMidgame(midgame, depth, &heuristic, probCut, &signature, &totalNodes, &totalSeconds);
+    }
+    else{
+        LinearHeuristic heuristic(weightName);
+        runMidgame(midgame, depth, &heuristic, probCut, &signature, &totalNodes, &totalSeconds);
+    }
+
+    for(int i = 0; i < (int)endgame.size(); i++){
+        EndgameSolver solver(numThreads);
+        Move best = NULL_MOVE(endgame[i].side);
+        auto start = chrono::steady_clock::now();
+        int score = solver.solve(&endgame[i].board, endgame[i].side, true, &best);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        long long nodes = solver.getNodeCount();
+        int empties = 64 - endgame[i].board.count(BLACK) - endgame[i].board.count(WHITE);
+        cout << "{\"suite\":\"endgame\",\"id\":" << i + 1
+             << ",\"empties\":" << empties
+             << ",\"nodes\":" << nodes
+             << ",\"ms\":" << seconds * 1000
+             << ",\"nps\":" << (long long)(nodes / max(seconds, 1e-9))
+             << ",\"score\":" << score
+             << ",\"move\":" << moveJson(best) << "}" << endl;
+
+        signature = fold(fold(signature, nodes), best.getData());
+        totalNodes += nodes;
+        totalSeconds += seconds;
+    }
+
+    cout << "{\"summary\":true,\"depth\":" << depth
+         << ",\"threads\":" << numThreads
+         << ",\"selective\":" << (probCut ? "true" : "false")
+         << ",\"positions\":" << midgame.size() + endgame.size()
+         << ",\"nodes\":" << totalNodes
+         << ",\"ms\":" << totalSeconds * 1000
+         << ",\"nps\":" << (long long)(totalNodes / max(totalSeconds, 1e-9))
+         << ",\"signature\":\"" << hex << signature << dec << "\"}" << endl;
+
+    return 0;
+}
@@ -7,16 +7,28 @@
 
 #define LEFT_MASK 0xfefefefefefefefeULL
 #define RIGHT_MASK 0x7f7f7f7f7f7f7f7fULL
-
-static Direction directions[8] = {NW, N, NE, E, SE, S, SW, W};
+// Squares that are not on an edge
+#define INNER_MASK 0x007e7e7e7e7e7e00ULL
 
 #define PIECE_HASH(x, y, side) pieceHash[side*64 + y*8 + x]
-#define MOVE_HASH(x, y, direction, length) moveHash[direction*384 + (length-1)*64 + y*8 + x]
+#define FLIP_HASH(byte, bits) flipHash[(byte)*256 + (bits)]
+
+// Bit position of a square, matching GET and FLIP
+#define POS(x, y) ((7-x) + 8 * (7-y))
 
-bool Board::isHashInit = false;
+bool Board::isTableInit = false;
 unsigned long long Board::pieceHash[128];
-unsigned long long Board::moveHash[3072];
+unsigned long long Board::flipHash[2048];
 unsigned long long Board::defaultHash;
+unsigned long long Board::lineMask[512];
+unsigned char Board::patternTypes[NUM_PATTERNS];
+const unsigned char Board::patternSizes[NUM_PATTERN_TYPES] = {10, 9, 10, 8, 7, 6, 5, 4};
+unsigned char Board::patternSquares[NUM_PATTERNS * MAX_PATTERN_SIZE];
+unsigned char Board::squarePatterns[64 * MAX_SQUARE_PATTERNS];
+unsigned short Board::squarePowers[64 * MAX_SQUARE_PATTERNS];
+unsigned char Board::edgeStable[6561];
+unsigned short Board::edgeCodes[256];
+unsigned long long Board::columnBits[256];
 
 void Board::initHash(){
     mt19937_64 generator(1337);
@@ -31,55 +43,141 @@ void Board::initHash(){
     defaultHash = PIECE_HASH(3, 3, WHITE) ^ PIECE_HASH(4, 3, BLACK)
                 ^ PIECE_HASH(3, 4, BLACK) ^ PIECE_HASH(4, 4, WHITE);
 
+    // A flipped piece changes sides, so its hash toggles both entries. Each
+    // byte of a flip mask is looked up separately.
+    for (int byte = 0; byte < 8; byte++) {
+        for (int bits = 0; bits < 256; bits++) {
+            unsigned long long hash = BLANK;
+            for (int i = 0; i < 8; i++) {
+                if (bits & (1 << i)) {
+                    int pos = byte * 8 + i;
+                    int x = 7 - (pos % 8);
+                    int y = 7 - (pos / 8);
+                    hash ^= PIECE_HASH(x, y, BLACK) ^ PIECE_HASH(x, y, WHITE);
+                }
+            }
+            FLIP_HASH(byte, bits) = hash;
+        }
+    }
+}
+
+void Board::initLines(){
     //                        NW,  N, NE, E, SE, S, SW,  W
     int xDirectionDelta[8] = {-1,  0,  1, 1,  1, 0, -1, -1};
     int yDirectionDelta[8] = {-1, -1, -1, 0,  1, 1,  1,  0};
 
     for (int dir = 0; dir < 8; dir++) {
-        for (int len = 1; len <= 6; len++) {
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-
-                    bool isValidMove = true;
-                    unsigned long long hash = BLANK;
-                    int length = len;
-                    int yPos = y;
-                    int xPos = x;
-
-                    while (length > 0) {
-                        yPos += yDirectionDelta[dir];
-                        xPos += xDirectionDelta[dir];
-                        length --;
-
-                        if((yDirectionDelta[dir] != 0 && (yPos <= 0 || yPos >= 7)) ||
-                           (xDirectionDelta[dir] != 0 && (xPos <= 0 || xPos >= 7))) {
-                            isValidMove = false;
-                            break;
-                        }
-
-                        hash ^= PIECE_HASH(xPos, yPos, BLACK);
-                        hash ^= PIECE_HASH(xPos, yPos, WHITE);
-                    }
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                unsigned long long line = BLANK;
+                int xPos = x + xDirectionDelta[dir];
+                int yPos = y + yDirectionDelta[dir];
+                while (xPos >= 0 && xPos < 8 && yPos >= 0 && yPos < 8) {
+                    FLIP(line, xPos, yPos);
+                    xPos += xDirectionDelta[dir];
+                    yPos += yDirectionDelta[dir];
+                }
+                lineMask[POS(x, y) * 8 + dir] = line;
+            }
+        }
+    }
+}
 
-                    if (isValidMove) {
-                        MOVE_HASH(x, y, dir, len) = hash;
-                    }
-                    else {
-                        MOVE_HASH(x, y, dir, len) = BLANK;
+void Board::initPatterns(){
+    // Each type is given as squares near the top left corner and repeated
+    // for the other corners or edges by turning the board a quarter at a time.
+    // Mirrored instances list their squares mirrored as well.
+    static const int shapes[NUM_PATTERN_TYPES][MAX_PATTERN_SIZE * 2] = {
+        {0,0, 1,0, 2,0, 3,0, 4,0, 5,0, 6,0, 7,0, 1,1, 6,1},
+        {0,0, 1,0, 2,0, 0,1, 1,1, 2,1, 0,2, 1,2, 2,2},
+        {0,0, 1,0, 2,0, 3,0, 4,0, 0,1, 1,1, 2,1, 3,1, 4,1},
+        {0,0, 1,1, 2,2, 3,3, 4,4, 5,5, 6,6, 7,7},
+        {0,1, 1,2, 2,3, 3,4, 4,5, 5,6, 6,7},
+        {0,2, 1,3, 2,4, 3,5, 4,6, 5,7},
+        {0,3, 1,4, 2,5, 3,6, 4,7},
+        {0,4, 1,5, 2,6, 3,7}
+    };
+    // The main diagonals only have two distinct turns
+    static const int turns[NUM_PATTERN_TYPES] = {4, 4, 4, 2, 4, 4, 4, 4};
+    static const bool isMirrored[NUM_PATTERN_TYPES] =
+                        {false, false, true, false, false, false, false, false};
+
+    int counts[64] = {0};
+    for (int i = 0; i < 64 * MAX_SQUARE_PATTERNS; i++) {
+        squarePatterns[i] = NUM_PATTERNS;
+        squarePowers[i] = 0;
+    }
+
+    int pattern = 0;
+    for (int type = 0; type < NUM_PATTERN_TYPES; type++) {
+        for (int mirror = 0; mirror <= (int)isMirrored[type]; mirror++) {
+            for (int turn = 0; turn < turns[type]; turn++) {
+                int power = 1;
+                for (int i = 0; i < patternSizes[type]; i++) {
+                    int x = shapes[type][i * 2 + mirror];
+                    int y = shapes[type][i * 2 + 1 - mirror];
+                    for (int j = 0; j < turn; j++) {
+                        int oldX = x;
+                        x = 7 - y;
+                        y = oldX;
                     }
+                    int pos = POS(x, y);
+                    patternSquares[pattern * MAX_PATTERN_SIZE + i] = pos;
+                    int k = counts[pos]++;
+                    squarePatterns[pos * MAX_SQUARE_PATTERNS + k] = pattern;
+                    squarePowers[pos * MAX_SQUARE_PATTERNS + k] = power;
+                    power *= 3;
                 }
+                patternTypes[pattern++] = type;
             }
         }
     }
 }
 
+void Board::initStability(){
+    for (int bits = 0; bits < 256; bits++) {
+        edgeCodes[bits] = 0;
+        columnBits[bits] = BLANK;
+        for (int i = 7; i >= 0; i--) {
+            edgeCodes[bits] = edgeCodes[bits] * 3 + ((bits >> i) & 1);
+            if (bits & (1 << i)) {
+                columnBits[bits] |= 0x1ULL << (8 * i);
+            }
+        }
+    }
+
+    // A full edge is stable. Otherwise a piece on an edge is only stable
+    // along it when it is joined to its own corner by a run of its own pieces.
+    for (int own = 0; own < 256; own++) {
+        for (int opp = 0; opp < 256; opp++) {
+            if (own & opp) {
+                continue;
+            }
+            int stable = own;
+            if ((own | opp) != 0xff) {
+                stable = 0;
+                for (int i = 0; i < 8 && (own & (1 << i)); i++) {
+                    stable |= 1 << i;
+                }
+                for (int i = 7; i >= 0 && (own & (1 << i)); i--) {
+                    stable |= 1 << i;
+                }
+            }
+            edgeStable[edgeCodes[own] + 2 * edgeCodes[opp]] = stable;
+        }
+    }
+}
+
 /**
  * Constructs a new board
  */
 Board::Board(){
-    if(!isHashInit) {
+    if(!isTableInit) {
         initHash();
-        isHashInit = true;
+        initLines();
+        initPatterns();
+        initStability();
+        isTableInit = true;
     }
     pieces[WHITE] = 0x0000001008000000ULL;
     pieces[BLACK] = 0x0000000810000000ULL;
@@ -87,6 +185,7 @@ Board::Board(){
     isMovesCalc[BLACK] = false;
     parity = WHITE;
     hash = defaultHash;
+    isPatternTracked = false;
 }
 
 /**
@@ -103,16 +202,16 @@ Board* Board::copy(){
     Board *newBoard = new Board();
     newBoard->pieces[WHITE] = pieces[WHITE];
     newBoard->pieces[BLACK] = pieces[BLACK];
-    for(int i = 0; i < 8; i++){
-        newBoard->moves[WHITE][i] = moves[WHITE][i];
-        newBoard->moves[BLACK][i] = moves[BLACK][i];
-    }
     newBoard->allMoves[WHITE] = allMoves[WHITE];
     newBoard->allMoves[BLACK] = allMoves[BLACK];
     newBoard->isMovesCalc[WHITE] = isMovesCalc[WHITE];
     newBoard->isMovesCalc[BLACK] = isMovesCalc[BLACK];
     newBoard->parity = parity;
     newBoard->hash = hash;
+    newBoard->isPatternTracked = isPatternTracked;
+    for (int i = 0; i <= NUM_PATTERNS; i++) {
+        newBoard->patterns[i] = patterns[i];
+    }
     return newBoard;
 }
 
@@ -138,39 +237,94 @@ void Board::printBoard(){
 }
 
 /**
- * Shifts a grid of bits in the specified direction
+ * Shifts a grid of bits by a fixed number of positions. Positive counts shift
+ * left, negative counts shift right.
  * @param bits Grid of bits to shift
- * @param dir  Direction to shift bits
  */
-unsigned long long Board::shiftBits(unsigned long long bits, Direction dir){
-    switch(dir){
-        case W:
-        return (bits << 1) & LEFT_MASK;
-
-        case NW:
-        return (bits << 9) & LEFT_MASK;
-
-        case N:
-        return (bits << 8);
-
-        case NE:
-        return (bits << 7) & RIGHT_MASK;
+template<int S>
+static inline unsigned long long shiftFixed(unsigned long long bits){
+    return S > 0 ? bits << (S & 63) : bits >> (-S & 63);
+}
 
-        case E:
-        return (bits >> 1) & RIGHT_MASK;
+/**
+ * Finds the moves for one direction using a Kogge-Stone occluded fill. The
+ * own pieces are flooded through contiguous runs of opponent pieces in three
+ * fixed steps, so no loop depends on the board contents.
+ * @param own   Pieces of the side to move
+ * @param opp   Pieces of the opponent
+ * @param empty Empty squares
+ * @return      Empty squares that outflank at least one opponent piece
+ */
+template<int S, unsigned long long MASK>
+static inline unsigned long long directionMoves(unsigned long long own,
+                        unsigned long long opp, unsigned long long empty){
+    unsigned long long pro = opp & MASK;
+    unsigned long long gen = own;
+    gen |= pro & shiftFixed<S>(gen);
+    pro &= shiftFixed<S>(pro);
+    gen |= pro & shiftFixed<2 * S>(gen);
+    pro &= shiftFixed<2 * S>(pro);
+    gen |= pro & shiftFixed<4 * S>(gen);
+    return empty & MASK & shiftFixed<S>(gen & opp);
+}
 
-        case SE:
-        return (bits >> 9) & RIGHT_MASK;
+/**
+ * Finds every move available to a side without touching a board
+ * @param  own Pieces of the side to move
+ * @param  opp Pieces of the opponent
+ * @return     Grid of bits with all legal moves set
+ */
+unsigned long long Board::findMoves(unsigned long long own, unsigned long long opp){
+    unsigned long long empty = ~(own | opp);
+    return directionMoves< 9, LEFT_MASK>(own, opp, empty)
+         | directionMoves< 8, ~BLANK>(own, opp, empty)
+         | directionMoves< 7, RIGHT_MASK>(own, opp, empty)
+         | directionMoves<-1, RIGHT_MASK>(own, opp, empty)
+         | directionMoves<-9, RIGHT_MASK>(own, opp, empty)
+         | directionMoves<-8, ~BLANK>(own, opp, empty)
+         | directionMoves<-7, LEFT_MASK>(own, opp, empty)
+         | directionMoves< 1, LEFT_MASK>(own, opp, empty);
+}
 
-        case S:
-        return (bits >> 8);
+/**
+ * Finds the pieces flipped by playing on a square. Each direction is resolved
+ * with one line mask lookup and a bit scan for the nearest piece that is not
+ * an opponent's, so the cost does not depend on how many pieces flip. Needs
+ * the tables built by the first Board constructor.
+ * @param  pos Bit position of the move
+ * @param  own Pieces of the side to move
+ * @param  opp Pieces of the opponent
+ * @return     Grid of bits with all flipped pieces set, empty if the move is
+ *             not legal
+ */
+unsigned long long Board::findFlips(int pos, unsigned long long own,
+                                        unsigned long long opp){
+    unsigned long long flips = BLANK;
+    const unsigned long long* lines = &lineMask[pos * 8];
 
-        case SW:
-        return (bits >> 7) & LEFT_MASK;
+    // NW, N, NE and W walk towards higher bits, so the nearest square that
+    // ends a run is the lowest set bit
+    static const Direction up[4] = {NW, N, NE, W};
+    for(int i = 0; i < 4; i++){
+        unsigned long long line = lines[up[i]];
+        unsigned long long stop = line & ~opp;
+        unsigned long long first = stop & (0 - stop);
+        unsigned long long run = line & (first - 1);
+        flips |= (first & own) ? run : BLANK;
+    }
 
-        default:
-        return bits;
+    // E, SE, S and SW walk towards lower bits, so it is the highest set bit
+    static const Direction down[4] = {E, SE, S, SW};
+    for(int i = 0; i < 4; i++){
+        unsigned long long line = lines[down[i]];
+        unsigned long long stop = line & ~opp;
+        unsigned long long first = (0x8000000000000000ULL >>
+                                    __builtin_clzll(stop | 1)) & stop;
+        unsigned long long run = line & (0 - (first << 1));
+        flips |= (first & own) ? run : BLANK;
     }
+
+    return flips;
 }
 
 /**
@@ -179,19 +333,7 @@ unsigned long long Board::shiftBits(unsigned long long bits, Direction dir){
  * @param side Side to calculate the possible moves for
  */
 void Board::calcMoves(bool side){
-    unsigned long long empty = ~(pieces[side] | pieces[!side]);
-    for(int i = 0; i < 8; i++){
-        moves[side][i] = BLANK;
-    }
-    allMoves[side] = BLANK;
-    for(int i = 0; i < 8; i++){
-        unsigned long long candidates = pieces[!side] & shiftBits(pieces[side], directions[i]);
-        while(candidates != BLANK){
-            moves[side][(i + 4) % 8] |= empty & shiftBits(candidates, directions[i]);
-            allMoves[side] |= empty & shiftBits(candidates, directions[i]);
-            candidates = pieces[!side] & shiftBits(candidates, directions[i]);
-        }
-    }
+    allMoves[side] = findMoves(pieces[side], pieces[!side]);
     isMovesCalc[side] = true;
 }
 
@@ -220,27 +362,39 @@ int Board::countMoves(bool side){
 }
 
 /**
- * Returns a vector of possible moves that a given side can make
+ * Returns a list of possible moves that a given side can make, in row-major
+ * order. A side with no moves gets a single null move.
  * @param side Side to calculate moves for
  */
-vector<Move> Board::possibleMoves(bool side){
+MoveList Board::possibleMoves(bool side){
     if(!isMovesCalc[side]){
         calcMoves(side);
     }
-    vector<Move> ret = vector<Move>();
-    for(int y = 0; y < 8; y++){
-        for(int x = 0; x < 8; x++){
-            if(GET(allMoves[side], x, y)){
-                ret.push_back(Move(x, y, side));
-            }
-        }
+    MoveList ret;
+    unsigned long long bits = allMoves[side];
+    while(bits){
+        int pos = 63 - __builtin_clzll(bits);
+        ret.push(Move(7 - (pos % 8), 7 - (pos / 8), side));
+        bits ^= 0x1ULL << pos;
     }
     if(ret.size() == 0) {
-        ret.push_back(NULL_MOVE(side));
+        ret.push(NULL_MOVE(side));
     }
     return ret;
 }
 
+/**
+ * Gets the moves a side can make as a grid of bits
+ * @param  side Side to calculate moves for
+ * @return      Grid of bits with every legal move set
+ */
+unsigned long long Board::getMoves(bool side){
+    if(!isMovesCalc[side]){
+        calcMoves(side);
+    }
+    return allMoves[side];
+}
+
 /**
  * Checks if a certain move is valid for the specified side
  * @param  m    Move to check
@@ -255,37 +409,110 @@ bool Board::checkMove(Move m){
 }
 
 /**
- * Does a given move on the board
+ * Does a given move on the board. Illegal moves leave the board unchanged.
  * @param m    Move to do on the board
+ * @return     Grid of bits with the flipped pieces set, to pass to undoMove
  */
-void Board::doMove(Move m){
+unsigned long long Board::doMove(Move m){
     if (m.isNull()) {
         parity = !parity;
-        return;
+        return BLANK;
     }
-    if (!checkMove(m)) {return;}
     bool side = m.getSide();
     int x = m.getX();
     int y = m.getY();
     unsigned long long move = BLANK;
     FLIP(move, x, y);
-    FLIP(pieces[side], x, y);
-    hash ^= PIECE_HASH(x, y, side);
-    for(int i = 0; i < 8; i++){
-        if(move & moves[side][i]){
-            int len = 0;
-            unsigned long long target = shiftBits(move, directions[i]);
-            while(!(target & pieces[side])){
-                len ++;
-                pieces[side] |= target;
-                pieces[!side] ^= target;
-                target = shiftBits(target, directions[i]);
-            }
-            hash ^= MOVE_HASH(x, y, i, len);
+    if (move & (pieces[BLACK] | pieces[WHITE])) {return BLANK;}
+    unsigned long long flips = findFlips(POS(x, y), pieces[side], pieces[!side]);
+    if (!flips) {return BLANK;}
+    pieces[side] ^= flips | move;
+    pieces[!side] ^= flips;
+    hash ^= PIECE_HASH(x, y, side) ^ getFlipHash(flips);
+    isMovesCalc[WHITE] = false;
+    isMovesCalc[BLACK] = false;
+
+    // Placed piece goes from 0 to its side's digit, flipped pieces between 1
+    // and 2
+    if (isPatternTracked) {
+        updatePatterns(POS(x, y), side == BLACK ? 1 : 2);
+        for (unsigned long long bits = flips; bits; bits &= bits - 1) {
+            updatePatterns(__builtin_ctzll(bits), side == BLACK ? -1 : 1);
         }
     }
+    return flips;
+}
+
+/**
+ * Takes back a move made by doMove
+ * @param m     Move that was done on the board
+ * @param flips Flipped pieces returned by doMove for that move
+ */
+void Board::undoMove(Move m, unsigned long long flips){
+    if (m.isNull()) {
+        parity = !parity;
+        return;
+    }
+    if (!flips) {return;}
+    bool side = m.getSide();
+    int x = m.getX();
+    int y = m.getY();
+    unsigned long long move = BLANK;
+    FLIP(move, x, y);
+    pieces[side] ^= flips | move;
+    pieces[!side] ^= flips;
+    hash ^= PIECE_HASH(x, y, side) ^ getFlipHash(flips);
     isMovesCalc[WHITE] = false;
     isMovesCalc[BLACK] = false;
+
+    if (isPatternTracked) {
+        updatePatterns(POS(x, y), side == BLACK ? -1 : -2);
+        for (unsigned long long bits = flips; bits; bits &= bits - 1) {
+            updatePatterns(__builtin_ctzll(bits), side == BLACK ? 1 : -1);
+        }
+    }
+}
+
+/**
+ * Changes the digit of a square in every pattern it is part of
+ * @param pos   Bit position of the square
+ * @param delta Change in the square's digit
+ */
+void Board::updatePatterns(int pos, int delta){
+    for (int i = 0; i < MAX_SQUARE_PATTERNS; i++) {
+        patterns[squarePatterns[pos * MAX_SQUARE_PATTERNS + i]] +=
+                            delta * squarePowers[pos * MAX_SQUARE_PATTERNS + i];
+    }
+}
+
+/**
+ * Computes every pattern code from the pieces
+ */
+void Board::calcPatterns(){
+    for (int pattern = 0; pattern < NUM_PATTERNS; pattern++) {
+        int code = 0;
+        for (int i = patternSizes[patternTypes[pattern]] - 1; i >= 0; i--) {
+            unsigned long long square = 0x1ULL <<
+                                patternSquares[pattern * MAX_PATTERN_SIZE + i];
+            code = code * 3 + ((pieces[BLACK] & square) ? 1 :
+                               (pieces[WHITE] & square) ? 2 : 0);
+        }
+        patterns[pattern] = code;
+    }
+    patterns[NUM_PATTERNS] = 0;
+}
+
+/**
+ * Finds the change in hash caused by flipping a set of pieces
+ * @param  flips Grid of bits with the flipped pieces set
+ * @return       Value to XOR into the hash
+ */
+unsigned long long Board::getFlipHash(unsigned long long flips){
+    unsigned long long hash = BLANK;
+    for (int byte = 0; byte < 8; byte++) {
+        hash ^= FLIP_HASH(byte, (flips >> (byte * 8)) & 0xff);
+    }
+    return hash;
 }
 
 /**
@@ -339,6 +566,21 @@ void Board::setBoard(char data[]){
             }
         }
     }
+
+    if (isPatternTracked) {
+        calcPatterns();
+    }
+}
+
+/**
+ * Finds the squares next to a set of squares in any of the eight directions,
+ * spreading along rows first and then along columns
+ * @param  bits Grid of bits to spread
+ * @return      The squares of bits and all their neighbours
+ */
+static inline unsigned long long findNeighbours(unsigned long long bits){
+    unsigned long long row = bits | ((bits << 1) & LEFT_MASK) | ((bits >> 1) & RIGHT_MASK);
+    return row | (row << 8) | (row >> 8);
 }
 
 /**
@@ -347,14 +589,125 @@ void Board::setBoard(char data[]){
  * @return      Frontier of given side
  */
 int Board::getFrontierSize(bool side){
-    unsigned long long frontier = BLANK;
     unsigned long long empty = ~(pieces[side] | pieces[!side]);
+    return __builtin_popcountll(findNeighbours(pieces[side]) & empty);
+}
+
+/**
+ * Finds the squares from which a line in one direction stays occupied until
+ * it leaves the board, using a Kogge-Stone fill back from the edge
+ * @param  occupied Occupied squares
+ * @return          Squares joined to the edge by occupied squares
+ */
+template<int S, unsigned long long MASK>
+static inline unsigned long long filledToEdge(unsigned long long occupied){
+    // Squares whose next square in the direction is on the board
+    const unsigned long long inside = shiftFixed<-S>(shiftFixed<S>(~BLANK) & MASK);
+    unsigned long long pro = occupied & inside;
+    unsigned long long gen = occupied & ~inside;
+    gen |= pro & shiftFixed<-S>(gen);
+    pro &= shiftFixed<-S>(pro);
+    gen |= pro & shiftFixed<-2 * S>(gen);
+    pro &= shiftFixed<-2 * S>(pro);
+    gen |= pro & shiftFixed<-4 * S>(gen);
+    return gen;
+}
+
+/**
+ * Finds the squares on full lines in each of the four line directions. Rows
+ * and columns fold their bits together; diagonals are filled from both ends.
+ * @param occupied  Occupied squares
+ * @param fullLines Filled with the squares on full NW/SE, N/S, NE/SW and E/W
+ *                  lines
+ */
+static inline void findFullLines(unsigned long long occupied,
+                                        unsigned long long* fullLines){
+    fullLines[0] = filledToEdge< 9, LEFT_MASK>(occupied)
+                 & filledToEdge<-9, RIGHT_MASK>(occupied);
+
+    unsigned long long column = occupied & ((occupied << 8) | (occupied >> 56));
+    column &= (column << 16) | (column >> 48);
+    fullLines[1] = column & ((column << 32) | (column >> 32));
+
+    fullLines[2] = filledToEdge< 7, RIGHT_MASK>(occupied)
+                 & filledToEdge<-7, LEFT_MASK>(occupied);
+
+    unsigned long long row = occupied & (occupied >> 4);
+    row &= row >> 2;
+    row &= row >> 1;
+    fullLines[3] = (row & 0x0101010101010101ULL) * 0xff;
+}
 
-    for(int i = 0; i < 8; i++){
-        frontier |= (shiftBits(pieces[side], directions[i]) & empty);
+/**
+ * Spreads stability from the edges over the inner squares until nothing
+ * changes. An inner piece is stable when, along each of the four lines
+ * through it, it is on a full line or next to a stable piece.
+ * @param  own       Pieces of the side to find stable pieces for
+ * @param  stable    Stable pieces of the side on the edges
+ * @param  fullLines Squares on full lines, from findFullLines
+ * @return           Grid of bits with all stable pieces set
+ */
+static inline unsigned long long spreadStable(unsigned long long own,
+            unsigned long long stable, const unsigned long long* fullLines){
+    unsigned long long inner = own & INNER_MASK;
+    if(!inner){
+        return stable;
     }
 
-    return __builtin_popcountll(frontier);
+    // Inner squares have all their neighbours on the board, so the shifts
+    // need no masks
+    unsigned long long last;
+    do{
+        last = stable;
+        stable |= inner
+            & (fullLines[0] | (stable << 9) | (stable >> 9))
+            & (fullLines[1] | (stable << 8) | (stable >> 8))
+            & (fullLines[2] | (stable << 7) | (stable >> 7))
+            & (fullLines[3] | (stable << 1) | (stable >> 1));
+    } while(stable != last);
+
+    return stable;
+}
+
+/**
+ * Finds the stable pieces of a side on the four edges. A full edge is
+ * stable; otherwise a piece is stable along an edge when a run of its own
+ * pieces joins it to its own corner. Each edge only depends on its own eight
+ * squares, so it is looked up by its ternary code. Needs the tables built by
+ * the first Board constructor.
+ * @param  own Pieces of the side to find stable pieces for
+ * @param  opp Pieces of the other side
+ * @return     Grid of bits with the stable edge pieces set
+ */
+unsigned long long Board::findEdgeStable(unsigned long long own, unsigned long long opp){
+    // Rows, then columns packed into a byte with row i at bit i
+    return ((unsigned long long)edgeStable[edgeCodes[own >> 56] +
+                                2 * edgeCodes[opp >> 56]] << 56)
+      | edgeStable[edgeCodes[own & 0xff] + 2 * edgeCodes[opp & 0xff]]
+      | columnBits[edgeStable[
+            edgeCodes[((own & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56] +
+        2 * edgeCodes[((opp & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56]]]
+      | columnBits[edgeStable[
+            edgeCodes[(((own >> 7) & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56] +
+        2 * edgeCodes[(((opp >> 7) & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56]]] << 7;
+}
+
+/**
+ * Finds the stable pieces of a side. A piece is stable when, along each of
+ * the four lines through it, it is on an edge, on a full line, or next to a
+ * stable piece. Needs the tables built by the first Board constructor.
+ * @param  own Pieces of the side to find stable pieces for
+ * @param  opp Pieces of the other side
+ * @return     Grid of bits with all stable pieces set
+ */
+unsigned long long Board::findStable(unsigned long long own, unsigned long long opp){
+    unsigned long long stable = findEdgeStable(own, opp);
+    if(!(own & INNER_MASK)){
+        return stable;
+    }
+    unsigned long long fullLines[4];
+    findFullLines(own | opp, fullLines);
+    return spreadStable(own, stable, fullLines);
 }
 
 /**
@@ -363,67 +716,149 @@ int Board::getFrontierSize(bool side){
  * @return      Number of stable pieces
  */
 int Board::countStable(bool side){
-    unsigned long long fullStable = BLANK;
-    unsigned long long partialStable[4];
-    // Add partial stability to edges/corners
-    // NW/SE
-    partialStable[0] = pieces[side] & 0xff818181818181ffULL;
-    // N/S
-    partialStable[1] = pieces[side] & 0xff000000000000ffULL;
-    // NE/SW
-    partialStable[2] = pieces[side] & 0xff818181818181ffULL;
-    // E/W
-    partialStable[3] = pieces[side] & 0x8181818181818181ULL;
-
-    // Add partial stability to pieces in full rows/columns/diagonals
-    // Diagonals NW/SE
-    unsigned long long filter = 0x0000000000000080ULL;
-    for(int i = 0; i < 15; i++){
-        if(filter == (filter & (pieces[BLACK] | pieces[WHITE]))){
-            partialStable[0] |= (filter & pieces[side]);
-        }
-        filter = shiftBits(filter, N) | shiftBits(filter, E);
+    return __builtin_popcountll(findStable(pieces[side], pieces[!side]));
+}
+
+/**
+ * Computes the evaluation features of both sides at once. Moves are found
+ * once per side and kept for later move generation, and the full lines used
+ * for stability are shared by both sides.
+ * @param features       Features to fill in
+ * @param isStableNeeded False to skip counting stable pieces, leaving them 0
+ */
+void Board::getFeatures(BoardFeatures* features, bool isStableNeeded){
+    if(!isMovesCalc[BLACK]){
+        calcMoves(BLACK);
     }
-    // Columns N/S
-    filter = 0x8080808080808080ULL;
-    for(int i = 0; i < 8; i++){
-        if(filter == (filter & (pieces[BLACK] | pieces[WHITE]))){
-            partialStable[1] |= (filter & pieces[side]);
-        }
-        filter = shiftBits(filter, E);
+    if(!isMovesCalc[WHITE]){
+        calcMoves(WHITE);
     }
-    // Diagonals NE/SW
-    filter = 0x8000000000000000ULL;
-    for(int i = 0; i < 15; i++){
-        if(filter == (filter & (pieces[BLACK] | pieces[WHITE]))){
-            partialStable[2] |= (filter & pieces[side]);
+    unsigned long long occupied = pieces[BLACK] | pieces[WHITE];
+    unsigned long long empty = ~occupied;
+
+    features->isDone = occupied == ~BLANK || !(allMoves[BLACK] | allMoves[WHITE]);
+    features->parity = parity;
+    features->discs[BLACK] = __builtin_popcountll(pieces[BLACK]);
+    features->discs[WHITE] = __builtin_popcountll(pieces[WHITE]);
+    features->mobility[BLACK] = __builtin_popcountll(allMoves[BLACK]);
+    features->mobility[WHITE] = __builtin_popcountll(allMoves[WHITE]);
+    features->frontier[BLACK] = __builtin_popcountll(findNeighbours(pieces[BLACK]) & empty);
+    features->frontier[WHITE] = __builtin_popcountll(findNeighbours(pieces[WHITE]) & empty);
+
+    features->stable[BLACK] = 0;
+    features->stable[WHITE] = 0;
+    if(isStableNeeded){
+        unsigned long long fullLines[4];
+        findFullLines(occupied, fullLines);
+        for(int side = 0; side <= 1; side++){
+            features->stable[side] = __builtin_popcountll(spreadStable(pieces[side],
+                    findEdgeStable(pieces[side], pieces[!side]), fullLines));
         }
-        filter = shiftBits(filter, S) | shiftBits(filter, E);
     }
-    // Rows E/W
-    filter = 0xff00000000000000ULL;
-    for(int i = 0; i < 8; i++){
-        if(filter == (filter & (pieces[BLACK] | pieces[WHITE]))){
-            partialStable[3] |= (filter & pieces[side]);
-        }
-        filter = shiftBits(filter, S);
+}
+
+/**
+ * Computes the evaluation features of every position one move away, without
+ * making the moves. Each child reuses the parent's pieces and empty squares,
+ * and the children are worked on in separate passes over arrays, so the
+ * passes without table lookups can be spread over vector registers when the
+ * compiler targets them.
+ * @param  side           Side making the moves
+ * @param  moves          Grid of bits with the moves to make set
+ * @param  features       Filled in for each move, highest bit first like
+ *                        possibleMoves
+ * @param  isStableNeeded False to skip counting stable pieces, leaving them 0
+ * @param  flips          If not nullptr, set to the pieces each move flips
+ * @return                Number of children
+ */
+int Board::getChildFeatures(bool side, unsigned long long moves,
+            BoardFeatures* features, bool isStableNeeded,
+            unsigned long long* flips){
+    unsigned long long own[MAX_MOVES];
+    unsigned long long opp[MAX_MOVES];
+    unsigned long long childFlips[MAX_MOVES];
+    unsigned long long squares[MAX_MOVES];
+    int n = 0;
+    for(unsigned long long bits = moves; bits; n++){
+        int pos = 63 - __builtin_clzll(bits);
+        squares[n] = 0x1ULL << pos;
+        childFlips[n] = findFlips(pos, pieces[side], pieces[!side]);
+        own[n] = pieces[side] | childFlips[n] | squares[n];
+        opp[n] = pieces[!side] ^ childFlips[n];
+        bits ^= squares[n];
     }
 
-    // Define full stable as intersection of partials
-    fullStable = partialStable[0] & partialStable[1] & partialStable[2] & partialStable[3];
+    unsigned long long ownMoves[MAX_MOVES];
+    unsigned long long oppMoves[MAX_MOVES];
+    for(int i = 0; i < n; i++){
+        ownMoves[i] = findMoves(own[i], opp[i]);
+        oppMoves[i] = findMoves(opp[i], own[i]);
+    }
 
-    // Loop until no changes are made to find all chained stable pieces
-    unsigned long long updateStable = fullStable;
-    do{
-        fullStable = updateStable;
-        for(int i = 0; i < 4; i++){
-            partialStable[i] |= pieces[side] & shiftBits(fullStable, directions[i]);
-            partialStable[i] |= pieces[side] & shiftBits(fullStable, directions[i+4]);
+    // A move fills one empty square, so the parent's empties minus it are
+    // the child's
+    unsigned long long empty = ~(pieces[BLACK] | pieces[WHITE]);
+    for(int i = 0; i < n; i++){
+        unsigned long long childEmpty = empty ^ squares[i];
+        features[i].isDone = !childEmpty || !(ownMoves[i] | oppMoves[i]);
+        features[i].parity = parity;
+        features[i].discs[side] = __builtin_popcountll(own[i]);
+        features[i].discs[!side] = __builtin_popcountll(opp[i]);
+        features[i].mobility[side] = __builtin_popcountll(ownMoves[i]);
+        features[i].mobility[!side] = __builtin_popcountll(oppMoves[i]);
+        features[i].frontier[side] = __builtin_popcountll(findNeighbours(own[i]) & childEmpty);
+        features[i].frontier[!side] = __builtin_popcountll(findNeighbours(opp[i]) & childEmpty);
+        features[i].stable[BLACK] = 0;
+        features[i].stable[WHITE] = 0;
+    }
+
+    if(isStableNeeded){
+        for(int i = 0; i < n; i++){
+            unsigned long long fullLines[4];
+            findFullLines(own[i] | opp[i], fullLines);
+            features[i].stable[side] = __builtin_popcountll(spreadStable(own[i],
+                        findEdgeStable(own[i], opp[i]), fullLines));
+            features[i].stable[!side] = __builtin_popcountll(spreadStable(opp[i],
+                        findEdgeStable(opp[i], own[i]), fullLines));
         }
-        updateStable = partialStable[0] & partialStable[1] & partialStable[2] & partialStable[3];
-    } while(fullStable != updateStable);
+    }
 
-    return __builtin_popcountll(fullStable);
+    if(flips){
+        for(int i = 0; i < n; i++){
+            flips[i] = childFlips[i];
+        }
+    }
+    return n;
+}
+
+/**
+ * Computes the pattern codes of the position after a move, without making it.
+ * The board must have patterns enabled.
+ * @param side  Side making the move
+ * @param pos   Bit position of the move
+ * @param flips Pieces the move flips
+ * @param codes Set to the codes of the child, NUM_PATTERNS + 1 of them
+ */
+void Board::getChildPatterns(bool side, int pos, unsigned long long flips,
+                                                    unsigned short* codes){
+    assert(isPatternTracked);
+    for(int i = 0; i <= NUM_PATTERNS; i++){
+        codes[i] = patterns[i];
+    }
+    // Same digit changes as doMove
+    int placed = side == BLACK ? 1 : 2;
+    int flipped = side == BLACK ? -1 : 1;
+    for(int i = 0; i < MAX_SQUARE_PATTERNS; i++){
+        codes[squarePatterns[pos * MAX_SQUARE_PATTERNS + i]] +=
+                        placed * squarePowers[pos * MAX_SQUARE_PATTERNS + i];
+    }
+    for(unsigned long long bits = flips; bits; bits &= bits - 1){
+        int square = __builtin_ctzll(bits);
+        for(int i = 0; i < MAX_SQUARE_PATTERNS; i++){
+            codes[squarePatterns[square * MAX_SQUARE_PATTERNS + i]] +=
+                        flipped * squarePowers[square * MAX_SQUARE_PATTERNS + i];
+        }
+    }
 }
 
 /**
@@ -451,3 +886,216 @@ bool Board::getParity() {
 unsigned long long Board::getHash() {
     return hash;
 }
+
+/**
+ * Mixes the bits of a 64 bit value (splitmix64 finalizer)
+ */
+static inline unsigned long long mixBits(unsigned long long bits){
+    bits = (bits ^ (bits >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    bits = (bits ^ (bits >> 27)) * 0x94d049bb133111ebULL;
+    return bits ^ (bits >> 31);
+}
+
+/**
+ * Mirrors a grid of bits top to bottom, taking y to 7 - y
+ */
+unsigned long long Board::flipVertical(unsigned long long bits){
+    return __builtin_bswap64(bits);
+}
+
+/**
+ * Mirrors a grid of bits left to right, taking x to 7 - x
+ */
+unsigned long long Board::flipHorizontal(unsigned long long bits){
+    bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+    bits = ((bits >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((bits & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return bits;
+}
+
+/**
+ * Mirrors a grid of bits in the diagonal through (0, 0) and (7, 7), swapping
+ * x and y. Each delta swap exchanges the bits of one set of blocks with the
+ * bits the same distance across the diagonal.
+ */
+unsigned long long Board::flipDiagonal(unsigned long long bits){
+    unsigned long long t;
+    t = 0x0f0f0f0f00000000ULL & (bits ^ (bits << 28));
+    bits ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (bits ^ (bits << 14));
+    bits ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (bits ^ (bits << 7));
+    bits ^= t ^ (t >> 7);
+    return bits;
+}
+
+/**
+ * Applies one of the symmetries of the board to a grid of bits. The symmetry
+ * first swaps x and y if bit 2 is set, then mirrors x if bit 0 is set and y
+ * if bit 1 is set.
+ * @param  bits     Grid of bits
+ * @param  symmetry Symmetry to apply, from 0 to NUM_SYMMETRIES - 1
+ * @return          Transformed grid
+ */
+unsigned long long Board::transform(unsigned long long bits, int symmetry){
+    if(symmetry & 4){
+        bits = flipDiagonal(bits);
+    }
+    if(symmetry & 1){
+        bits = flipHorizontal(bits);
+    }
+    if(symmetry & 2){
+        bits = flipVertical(bits);
+    }
+    return bits;
+}
+
+/**
+ * Undoes transform
+ * @param  bits     Transformed grid of bits
+ * @param  symmetry Symmetry that was applied
+ * @return          Original grid
+ */
+unsigned long long Board::inverseTransform(unsigned long long bits, int symmetry){
+    if(symmetry & 1){
+        bits = flipHorizontal(bits);
+    }
+    if(symmetry & 2){
+        bits = flipVertical(bits);
+    }
+    if(symmetry & 4){
+        bits = flipDiagonal(bits);
+    }
+    return bits;
+}
+
+/**
+ * Moves a move to where one of the symmetries takes its square. Passes are
+ * left as they are.
+ * @param  m        Move to transform
+ * @param  symmetry Symmetry to apply
+ * @return          Move on the transformed square, for the same side
+ */
+Move Board::transformMove(Move m, int symmetry){
+    if(m.isNull()){
+        return m;
+    }
+    int pos = __builtin_ctzll(transform(0x1ULL << POS(m.getX(), m.getY()), symmetry));
+    return Move(7 - pos % 8, 7 - pos / 8, m.getSide());
+}
+
+/**
+ * Undoes transformMove
+ * @param  m        Transformed move
+ * @param  symmetry Symmetry that was applied
+ * @return          Move on the original square
+ */
+Move Board::inverseMove(Move m, int symmetry){
+    if(m.isNull()){
+        return m;
+    }
+    int pos = __builtin_ctzll(inverseTransform(0x1ULL << POS(m.getX(), m.getY()),
+                                                                    symmetry));
+    return Move(7 - pos % 8, 7 - pos / 8, m.getSide());
+}
+
+/**
+ * Finds a key that is the same for a position and all of its mirror images.
+ * The canonical orientation is the one with the smallest pair of bitboards.
+ * @param  own      Pieces of the side to move
+ * @param  opp      Pieces of the other side
+ * @param  symmetry Set to the symmetry that gives the canonical orientation,
+ *                  if not null
+ * @return          Key of the position
+ */
+unsigned long long Board::findCanonicalKey(unsigned long long own,
+                                unsigned long long opp, int* symmetry){
+    unsigned long long bestOwn = own;
+    unsigned long long bestOpp = opp;
+    int bestSymmetry = 0;
+    for(int s = 1; s < NUM_SYMMETRIES; s++){
+        unsigned long long newOwn = transform(own, s);
+        if(newOwn > bestOwn){
+            continue;
+        }
+        unsigned long long newOpp = transform(opp, s);
+        if(newOwn < bestOwn || newOpp < bestOpp){
+            bestOwn = newOwn;
+            bestOpp = newOpp;
+            bestSymmetry = s;
+        }
+    }
+    if(symmetry){
+        *symmetry = bestSymmetry;
+    }
+    return mixBits(bestOwn) ^ mixBits(bestOpp + 0x9e3779b97f4a7c15ULL);
+}
+
+/**
+ * Finds the key of the board that is shared by its mirror images
+ * @param  side     Side to move
+ * @param  symmetry Set to the symmetry that gives the canonical orientation,
+ *                  if not null
+ * @return          Key of the position with that side to move
+ */
+unsigned long long Board::getCanonicalKey(bool side, int* symmetry){
+    return findCanonicalKey(pieces[side], pieces[!side], symmetry);
+}
+
+/**
+ * Gets the raw bitboard of a side's pieces
+ * @param  side Side to get pieces for
+ * @return      Grid of bits with that side's pieces set
+ */
+unsigned long long Board::getPieces(bool side) {
+    return pieces[side];
+}
+
+/**
+ * Starts keeping the pattern codes up to date, so they can be read. Copies
+ * of the board keep them up to date as well.
+ */
+void Board::enablePatterns() {
+    if (!isPatternTracked) {
+        calcPatterns();
+        isPatternTracked = true;
+    }
+}
+
+/**
+ * Gets the ternary code of a pattern, with the first square of the pattern
+ * as the lowest digit. The board must have patterns enabled.
+ * @param  pattern Pattern instance to get
+ * @return         Code of the pattern
+ */
+int Board::getPattern(int pattern) {
+    assert(isPatternTracked);
+    return patterns[pattern];
+}
+
+/**
+ * Gets the codes of every pattern, indexed like getPattern
+ */
+const unsigned short* Board::getPatterns() {
+    assert(isPatternTracked);
+    return patterns;
+}
+
+/**
+ * Gets the type of a pattern instance
+ * @param  pattern Pattern instance
+ * @return         PatternType of the instance
+ */
+int Board::getPatternType(int pattern) {
+    return patternTypes[pattern];
+}
+
+/**
+ * Gets the number of squares in a type of pattern. Does not need the tables
+ * built by the first Board constructor.
+ * @param  type PatternType to get the size of
+ * @return      Number of squares
+ */
+int Board::getPatternSize(int type) {
+    return patternSizes[type];
+}
@@ -2,6 +2,7 @@
 #define __BOARD_H__
 
 #include <bitset>
+#include <cassert>
 #include <iostream>
 #include <random>
 #include "common.hpp"
@@ -9,31 +10,104 @@ using namespace std;
 
 enum Direction {NW, N, NE, E, SE, S, SW, W};
 
+// Patterns whose ternary codes the board keeps up to date once enabled. Every
+// instance of a type lists its squares in the same orientation, so they can
+// share weights.
+enum PatternType {EDGE_2X, CORNER_3X3, CORNER_2X5, DIAG_8, DIAG_7, DIAG_6,
+                                                        DIAG_5, DIAG_4};
+#define NUM_PATTERN_TYPES 8
+#define NUM_PATTERNS 34
+#define MAX_PATTERN_SIZE 10
+#define MAX_SQUARE_PATTERNS 6
+// Rotations and reflections of the board
+#define NUM_SYMMETRIES 8
+
+/**
+ * Evaluation features of a position, indexed by side. Board::getFeatures fills
+ * them in one pass so the heuristics share the intermediate results.
+ */
+typedef struct {
+    int discs[2];
+    int mobility[2];
+    int stable[2];
+    // Empty squares next to a side's pieces
+    int frontier[2];
+    bool parity;
+    bool isDone;
+} BoardFeatures;
+
 class Board {
 
 private:
     static unsigned long long pieceHash[128];
-    static unsigned long long moveHash[3072];
-    // 64 positions * 8 directions * 6 distances (min 1, max 6)
+    static unsigned long long flipHash[2048];
+    // 8 bytes of a flip mask * 256 values
     static unsigned long long defaultHash;
-    static bool isHashInit;
+    static unsigned long long lineMask[512];
+    // 64 positions * 8 directions
+    static bool isTableInit;
+    static unsigned char patternTypes[NUM_PATTERNS];
+    static const unsigned char patternSizes[NUM_PATTERN_TYPES];
+    static unsigned char patternSquares[NUM_PATTERNS * MAX_PATTERN_SIZE];
+    // Patterns each square is part of, with the square's power of 3 in them.
+    // Unused places point at a spare code with power 0, so updates do not
+    // branch on the count.
+    static unsigned char squarePatterns[64 * MAX_SQUARE_PATTERNS];
+    static unsigned short squarePowers[64 * MAX_SQUARE_PATTERNS];
+    // Stable squares of an edge for the side whose pieces are digit 1, by the
+    // ternary code of the edge
+    static unsigned char edgeStable[6561];
+    // Ternary code of a byte of pieces with every set bit as digit 1
+    static unsigned short edgeCodes[256];
+    // Spreads the bits of a byte over one column, bit i going to byte i
+    static unsigned long long columnBits[256];
 
     unsigned long long pieces[2];
 
-    unsigned long long moves[2][8];
     unsigned long long allMoves[2];
 
     unsigned long long hash;
     bool isMovesCalc[2];
 
-    unsigned long long shiftBits(unsigned long long bits, Direction dir);
+    // Digit of a square is 0 when empty, 1 for black and 2 for white
+    unsigned short patterns[NUM_PATTERNS + 1];
+    // Codes are only updated by moves on boards that enable them, so searches
+    // that never look at patterns don't pay for them
+    bool isPatternTracked;
+
     void calcMoves(bool side);
+    unsigned long long getFlipHash(unsigned long long flips);
+    void updatePatterns(int pos, int delta);
+    static unsigned long long findEdgeStable(unsigned long long own,
+                                        unsigned long long opp);
+    void calcPatterns();
     void printBits(unsigned long long bits);
 
     bool parity;
 
 public:
     static void initHash();
+    static void initLines();
+    static void initPatterns();
+    static void initStability();
+    static int getPatternType(int pattern);
+    static int getPatternSize(int type);
+    static unsigned long long findMoves(unsigned long long own,
+                                        unsigned long long opp);
+    static unsigned long long findFlips(int pos, unsigned long long own,
+                                        unsigned long long opp);
+    static unsigned long long findStable(unsigned long long own,
+                                        unsigned long long opp);
+    static unsigned long long flipVertical(unsigned long long bits);
+    static unsigned long long flipHorizontal(unsigned long long bits);
+    static unsigned long long flipDiagonal(unsigned long long bits);
+    static unsigned long long transform(unsigned long long bits, int symmetry);
+    static unsigned long long inverseTransform(unsigned long long bits,
+                                                            int symmetry);
+    static Move transformMove(Move m, int symmetry);
+    static Move inverseMove(Move m, int symmetry);
+    static unsigned long long findCanonicalKey(unsigned long long own,
+                                unsigned long long opp, int* symmetry = nullptr);
     Board();
     ~Board();
     Board *copy();
@@ -42,18 +116,31 @@ public:
     void test();
 
     int countStable(bool side);
-
-    vector<Move> possibleMoves(bool side);
+    void getFeatures(BoardFeatures* features, bool isStableNeeded = true);
+    int getChildFeatures(bool side, unsigned long long moves,
+                BoardFeatures* features, bool isStableNeeded = true,
+                unsigned long long* flips = nullptr);
+    void getChildPatterns(bool side, int pos, unsigned long long flips,
+                unsigned short* codes);
+
+    MoveList possibleMoves(bool side);
+    unsigned long long getMoves(bool side);
     bool getParity();
 
     bool isDone();
     bool hasMoves(bool side);
     int countMoves(bool side);
     bool checkMove(Move m);
-    void doMove(Move m);
+    unsigned long long doMove(Move m);
+    void undoMove(Move m, unsigned long long flips);
     int count(bool side);
     int getFrontierSize(bool side);
     unsigned long long getHash();
+    unsigned long long getCanonicalKey(bool side, int* symmetry = nullptr);
+    unsigned long long getPieces(bool side);
+    void enablePatterns();
+    int getPattern(int pattern);
+    const unsigned short* getPatterns();
 
     void setBoard(char data[]);
 };
@@ -0,0 +1,451 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "common.hpp"
+#include "board.hpp"
+
+#define NUM_POSITIONS 100000
+#define NUM_PASSES 20
+#define SEED 1337
+
+#define LEFT_MASK 0xfefefefefefefefeULL
+#define RIGHT_MASK 0x7f7f7f7f7f7f7f7fULL
+
+typedef struct {
+    unsigned long long own;
+    unsigned long long opp;
+} Position;
+
+/**
+ * Shifts a grid of bits in the specified direction. Copy of the original
+ * Board::shiftBits used by the reference kernels below.
+ */
+static unsigned long long legacyShift(unsigned long long bits, int dir){
+    switch(dir){
+        case 0: return (bits << 9) & LEFT_MASK;
+        case 1: return (bits << 8);
+        case 2: return (bits << 7) & RIGHT_MASK;
+        case 3: return (bits >> 1) & RIGHT_MASK;
+        case 4: return (bits >> 9) & RIGHT_MASK;
+        case 5: return (bits >> 8);
+        case 6: return (bits >> 7) & LEFT_MASK;
+        default: return (bits << 1) & LEFT_MASK;
+    }
+}
+
+/**
+ * Reference move generator: the original direction-by-direction loop
+ */
+static unsigned long long legacyMoves(unsigned long long own, unsigned long long opp){
+    unsigned long long empty = ~(own | opp);
+    unsigned long long moves = 0x0ULL;
+    for(int i = 0; i < 8; i++){
+        unsigned long long candidates = opp & legacyShift(own, i);
+        while(candidates){
+            moves |= empty & legacyShift(candidates, i);
+            candidates = opp & legacyShift(candidates, i);
+        }
+    }
+    return moves;
+}
+
+/**
+ * Reference flip finder: walks each direction one square at a time
+ */
+static unsigned long long legacyFlips(int pos, unsigned long long own,
+                                        unsigned long long opp){
+    unsigned long long move = 0x1ULL << pos;
+    unsigned long long flips = 0x0ULL;
+    for(int i = 0; i < 8; i++){
+        unsigned long long run = 0x0ULL;
+        unsigned long long target = legacyShift(move, i);
+        while(target & opp){
+            run |= target;
+            target = legacyShift(target, i);
+        }
+        if(target & own){
+            flips |= run;
+        }
+    }
+    return flips;
+}
+
+/**
+ * Reference stable piece finder: the original line-by-line scan followed by a
+ * fixpoint over all eight directions
+ */
+static unsigned long long legacyStable(unsigned long long own, unsigned long long opp){
+    unsigned long long occupied = own | opp;
+    unsigned long long partialStable[4];
+    partialStable[0] = own & 0xff818181818181ffULL;
+    partialStable[1] = own & 0xff000000000000ffULL;
+    partialStable[2] = own & 0xff818181818181ffULL;
+    partialStable[3] = own & 0x8181818181818181ULL;
+
+    unsigned long long filter = 0x0000000000000080ULL;
+    for(int i = 0; i < 15; i++){
+        if(filter == (filter & occupied)){
+            partialStable[0] |= filter & own;
+        }
+        filter = legacyShift(filter, 1) | legacyShift(filter, 3);
+    }
+    filter = 0x8080808080808080ULL;
+    for(int i = 0; i < 8; i++){
+        if(filter == (filter & occupied)){
+            partialStable[1] |= filter & own;
+        }
+        filter = legacyShift(filter, 3);
+    }
+    filter = 0x8000000000000000ULL;
+    for(int i = 0; i < 15; i++){
+        if(filter == (filter & occupied)){
+            partialStable[2] |= filter & own;
+        }
+        filter = legacyShift(filter, 5) | legacyShift(filter, 3);
+    }
+    filter = 0xff00000000000000ULL;
+    for(int i = 0; i < 8; i++){
+        if(filter == (filter & occupied)){
+            partialStable[3] |= filter & own;
+        }
+        filter = legacyShift(filter, 5);
+    }
+
+    unsigned long long fullStable;
+    unsigned long long updateStable = partialStable[0] & partialStable[1]
+                                    & partialStable[2] & partialStable[3];
+    do{
+        fullStable = updateStable;
+        for(int i = 0; i < 4; i++){
+            partialStable[i] |= own & legacyShift(fullStable, i);
+            partialStable[i] |= own & legacyShift(fullStable, i + 4);
+        }
+        updateStable = partialStable[0] & partialStable[1]
+                     & partialStable[2] & partialStable[3];
+    } while(fullStable != updateStable);
+    return fullStable;
+}
+
+/**
+ * Reference symmetry transform: moves every set square on its own, swapping
+ * x and y if bit 2 of the symmetry is set, then mirroring x for bit 0 and y
+ * for bit 1
+ */
+static unsigned long long legacyTransform(unsigned long long bits, int symmetry){
+    unsigned long long ret = 0x0ULL;
+    while(bits){
+        int pos = __builtin_ctzll(bits);
+        int x = 7 - pos % 8;
+        int y = 7 - pos / 8;
+        if(symmetry & 4){
+            swap(x, y);
+        }
+        if(symmetry & 1){
+            x = 7 - x;
+        }
+        if(symmetry & 2){
+            y = 7 - y;
+        }
+        ret |= 0x1ULL << ((7 - x) + 8 * (7 - y));
+        bits &= bits - 1;
+    }
+    return ret;
+}
+
+/**
+ * Collects positions from random games so the benchmark sees a realistic mix
+ * of openings, midgames and endgames
+ */
+static vector<Position> collectPositions(int count){
+    mt19937 generator(SEED);
+    vector<Position> positions;
+    while((int)positions.size() < count){
+        Board board;
+        bool side = BLACK;
+        while(!board.isDone() && (int)positions.size() < count){
+            Position p = {board.getPieces(side), board.getPieces(!side)};
+            positions.push_back(p);
+            MoveList moves = board.possibleMoves(side);
+            board.doMove(moves[generator() % moves.size()]);
+            side = !side;
+        }
+    }
+    return positions;
+}
+
+/**
+ * Times a move generator over every position
+ * @return Generated moves per second
+ */
+template<typename F>
+static double timeMoves(const char* name, F kernel,
+                                vector<Position>& positions){
+    unsigned long long total = 0;
+    unsigned long long check = 0;
+    auto start = chrono::steady_clock::now();
+    for(int pass = 0; pass < NUM_PASSES; pass++){
+        for(int i = 0; i < (int)positions.size(); i++){
+            unsigned long long moves = kernel(positions[i].own, positions[i].opp);
+            total += __builtin_popcountll(moves);
+            check += moves;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double calls = (double)positions.size() * NUM_PASSES;
+    cout << name << ": " << calls / seconds / 1e6 << " Mgen/s, "
+         << total / seconds / 1e6 << " Mmoves/s (check " << hex << check
+         << dec << ")" << endl;
+    return total / seconds;
+}
+
+/**
+ * Times a flip finder over every legal move of every position
+ * @return Flipped pieces per second
+ */
+template<typename F>
+static double timeFlips(const char* name, F kernel,
+                                vector<Position>& positions){
+    unsigned long long total = 0;
+    unsigned long long check = 0;
+    auto start = chrono::steady_clock::now();
+    for(int pass = 0; pass < NUM_PASSES; pass++){
+        for(int i = 0; i < (int)positions.size(); i++){
+            unsigned long long moves = Board::findMoves(positions[i].own, positions[i].opp);
+            while(moves){
+                unsigned long long flips = kernel(__builtin_ctzll(moves),
+                                        positions[i].own, positions[i].opp);
+                total += __builtin_popcountll(flips);
+                check += flips;
+                moves &= moves - 1;
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << total / seconds / 1e6 << " Mflips/s (check "
+         << hex << check << dec << ")" << endl;
+    return total / seconds;
+}
+
+/**
+ * Times a stable piece finder for both sides of every position
+ * @return Positions per second
+ */
+template<typename F>
+static double timeStable(const char* name, F kernel,
+                                vector<Position>& positions){
+    unsigned long long total = 0;
+    unsigned long long check = 0;
+    auto start = chrono::steady_clock::now();
+    for(int pass = 0; pass < NUM_PASSES; pass++){
+        for(int i = 0; i < (int)positions.size(); i++){
+            unsigned long long own = kernel(positions[i].own, positions[i].opp);
+            unsigned long long opp = kernel(positions[i].opp, positions[i].own);
+            total += __builtin_popcountll(own) + __builtin_popcountll(opp);
+            check += own ^ opp;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double calls = (double)positions.size() * NUM_PASSES * 2;
+    cout << name << ": " << calls / seconds / 1e6 << " Mcalls/s, "
+         << total / calls << " stable/call (check " << hex << check << dec
+         << ")" << endl;
+    return calls / seconds;
+}
+
+/**
+ * Times a symmetry transform over both sides of every position under every
+ * symmetry
+ * @return Positions per second
+ */
+template<typename F>
+static double timeTransform(const char* name, F kernel,
+                                vector<Position>& positions){
+    unsigned long long check = 0;
+    auto start = chrono::steady_clock::now();
+    for(int pass = 0; pass < NUM_PASSES; pass++){
+        for(int i = 0; i < (int)positions.size(); i++){
+            for(int s = 0; s < NUM_SYMMETRIES; s++){
+                check += kernel(positions[i].own, s) ^ kernel(positions[i].opp, s);
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double calls = (double)positions.size() * NUM_PASSES * NUM_SYMMETRIES * 2;
+    cout << name << ": " << calls / seconds / 1e6 << " Mcalls/s (check " << hex
+         << check << dec << ")" << endl;
+    return calls / seconds;
+}
+
+/**
+ * Sets up a board from a position, with the side to move as black
+ */
+static void setPosition(Board* board, Position& p){
+    char data[64];
+    for(int i = 0; i < 64; i++){
+        unsigned long long square = 0x1ULL << (63 - i);
+        data[i] = (p.own & square) ? 'b' : (p.opp & square) ? 'w' : '-';
+    }
+    board->setBoard(data);
+}
+
+static bool isSameFeatures(BoardFeatures* a, BoardFeatures* b){
+    for(int side = 0; side <= 1; side++){
+        if(a->discs[side] != b->discs[side] || a->mobility[side] != b->mobility[side]
+                || a->stable[side] != b->stable[side]
+                || a->frontier[side] != b->frontier[side]){
+            return false;
+        }
+    }
+    return a->parity == b->parity && a->isDone == b->isDone;
+}
+
+/**
+ * Checks the batched features and pattern codes of every child of a position
+ * against making each move
+ * @return True if they all match
+ */
+static bool checkChildren(Position& p){
+    Board board;
+    setPosition(&board, p);
+    board.enablePatterns();
+    unsigned long long moves = board.getMoves(BLACK);
+    BoardFeatures features[MAX_MOVES];
+    unsigned long long flips[MAX_MOVES];
+    int n = board.getChildFeatures(BLACK, moves, features, true, flips);
+    MoveList list = board.possibleMoves(BLACK);
+    if(n != __builtin_popcountll(moves)){
+        return false;
+    }
+    for(int i = 0; i < n; i++){
+        int pos = 63 - __builtin_clzll(moves);
+        moves ^= 0x1ULL << pos;
+        unsigned short codes[NUM_PATTERNS + 1];
+        board.getChildPatterns(BLACK, pos, flips[i], codes);
+
+        unsigned long long made = board.doMove(list[i]);
+        BoardFeatures expected;
+        board.getFeatures(&expected);
+        bool isSame = made == flips[i] && isSameFeatures(&expected, &features[i]);
+        for(int j = 0; j < NUM_PATTERNS; j++){
+            isSame &= codes[j] == board.getPattern(j);
+        }
+        board.undoMove(list[i], made);
+        if(!isSame){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Times computing the features of every child of every position
+ * @param isBatched True to use getChildFeatures, false to make each move
+ * @return          Children per second
+ */
+static double timeChildren(const char* name, bool isBatched,
+                                vector<Position>& positions){
+    vector<Board> boards(positions.size());
+    for(int i = 0; i < (int)positions.size(); i++){
+        setPosition(&boards[i], positions[i]);
+    }
+    unsigned long long total = 0;
+    unsigned long long check = 0;
+    auto start = chrono::steady_clock::now();
+    for(int pass = 0; pass < NUM_PASSES; pass++){
+        for(int i = 0; i < (int)boards.size(); i++){
+            BoardFeatures features[MAX_MOVES];
+            int n = 0;
+            if(isBatched){
+                n = boards[i].getChildFeatures(BLACK, boards[i].getMoves(BLACK),
+                                                                    features);
+            }
+            else{
+                MoveList list = boards[i].possibleMoves(BLACK);
+                for(; n < list.size() && !list[n].isNull(); n++){
+                    unsigned long long flips = boards[i].doMove(list[n]);
+                    boards[i].getFeatures(&features[n]);
+                    boards[i].undoMove(list[n], flips);
+                }
+            }
+            for(int j = 0; j < n; j++){
+                check += features[j].mobility[BLACK] * 3 + features[j].stable[WHITE];
+            }
+            total += n;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << total / seconds / 1e6 << " Mchildren/s (check "
+         << hex << check << dec << ")" << endl;
+    return total / seconds;
+}
+
+// Microbenchmark and cross-check for the bitboard kernels in board.cpp
+int main(int argc, char *argv[]) {
+    vector<Position> positions = collectPositions(NUM_POSITIONS);
+
+    for(int i = 0; i < (int)positions.size(); i++){
+        if(legacyMoves(positions[i].own, positions[i].opp)
+                != Board::findMoves(positions[i].own, positions[i].opp)){
+            cerr << "Move generation mismatch at position " << i << endl;
+            return 1;
+        }
+        for(int pos = 0; pos < 64; pos++){
+            if((positions[i].own | positions[i].opp) & (0x1ULL << pos)){
+                continue;
+            }
+            if(legacyFlips(pos, positions[i].own, positions[i].opp)
+                    != Board::findFlips(pos, positions[i].own, positions[i].opp)){
+                cerr << "Flip mismatch at position " << i << endl;
+                return 1;
+            }
+        }
+        if(legacyStable(positions[i].own, positions[i].opp)
+                != Board::findStable(positions[i].own, positions[i].opp)
+            || legacyStable(positions[i].opp, positions[i].own)
+                != Board::findStable(positions[i].opp, positions[i].own)){
+            cerr << "Stability mismatch at position " << i << endl;
+            return 1;
+        }
+        for(int s = 0; s < NUM_SYMMETRIES; s++){
+            unsigned long long bits = positions[i].own;
+            if(legacyTransform(bits, s) != Board::transform(bits, s)
+                || Board::inverseTransform(Board::transform(bits, s), s) != bits){
+                cerr << "Symmetry mismatch at position " << i << endl;
+                return 1;
+            }
+        }
+        if(!checkChildren(positions[i])){
+            cerr << "Child feature mismatch at position " << i << endl;
+            return 1;
+        }
+    }
+
+    cout << "Move generation over " << positions.size() << " positions x "
+         << NUM_PASSES << " passes" << endl;
+    double legacy = timeMoves("loop       ", legacyMoves, positions);
+    double fill = timeMoves("kogge-stone", Board::findMoves, positions);
+    cout << "speedup: " << fill / legacy << "x" << endl;
+
+    cout << "Flip computation" << endl;
+    legacy = timeFlips("loop       ", legacyFlips, positions);
+    double lines = timeFlips("line masks ", Board::findFlips, positions);
+    cout << "speedup: " << lines / legacy << "x" << endl;
+
+    cout << "Stable pieces" << endl;
+    legacy = timeStable("loop       ", legacyStable, positions);
+    double table = timeStable("edge table ", Board::findStable, positions);
+    cout << "speedup: " << table / legacy << "x" << endl;
+
+    cout << "Symmetry transforms" << endl;
+    legacy = timeTransform("loop       ", legacyTransform, positions);
+    double swaps = timeTransform("delta swap ", Board::transform, positions);
+    cout << "speedup: " << swaps / legacy << "x" << endl;
+
+    cout << "Child features" << endl;
+    legacy = timeChildren("make/unmake", false, positions);
+    double batch = timeChildren("batched    ", true, positions);
+    cout << "speedup: " << batch / legacy << "x" << endl;
+
+    return 0;
+}
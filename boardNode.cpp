@@ -1,66 +1,256 @@
 #include "boardNode.hpp"
+#include "linearHeuristic.hpp"
+#include "timeHeuristic.hpp"
+#include "patternHeuristic.hpp"
 
-int nodeCount = 0;
-int maxNodeCount = 0;
-time_t startTime;
+// Static move ordering, highest first: corners, then edges away from the
+// corners, the inner squares, and last the squares next to the corners.
+// Symmetric, so it does not matter which way moves index it.
+const int BoardNode::squarePriority[64] = {
+    9, 1, 7, 6, 6, 7, 1, 9,
+    1, 0, 3, 3, 3, 3, 0, 1,
+    7, 3, 5, 4, 4, 5, 3, 7,
+    6, 3, 4, 2, 2, 4, 3, 6,
+    6, 3, 4, 2, 2, 4, 3, 6,
+    7, 3, 5, 4, 4, 5, 3, 7,
+    1, 0, 3, 3, 3, 3, 0, 1,
+    9, 1, 7, 6, 6, 7, 1, 9
+};
 
 /**
- * Constructs a child node
- * @param parentBoard Board from parent node
- * @param m Move made to get to this node from parent
+ * Constructs a base node
+ * @param board   Current board for the game
+ * @param ourSide The side that our player is on
  */
-BoardNode::BoardNode(Board* parentBoard, Move m) : lastMove(BLACK) {
-    board = parentBoard->copy();
-    board->doMove(m);
-    lastMove = m;
-    sideToMove = !m.getSide();
-
-    children = vector<BoardNode*>();
-    nodeCount += 1;
-    if(nodeCount > maxNodeCount){
-        maxNodeCount = nodeCount;
+BoardNode::BoardNode(Board* board, bool ourSide) : board(*board) {
+    this->board.doMove(NULL_MOVE(!ourSide));
+    sideToMove = ourSide;
+    softTimeLimit = -1;
+    hardTimeLimit = -1;
+    depthReached = 0;
+    helperId = 0;
+    stopFlag = nullptr;
+    isAborted = false;
+    nextTimeCheck = 0;
+    probCut = nullptr;
+    ply = 0;
+    for(int i = 0; i < MAX_SEARCH_PLY; i++){
+        for(int j = 0; j < NUM_KILLERS; j++){
+            killers[i][j] = NULL_MOVE(BLACK);
+        }
     }
+    memset(history, 0, sizeof(history));
+    startTime = chrono::steady_clock::now();
+}
 
+/**
+ * Deconstructs node
+ */
+BoardNode::~BoardNode(){
 }
 
 /**
- * Constructs a base node
- * @param board   Current board for the game
- * @param ourSide The side that our player is on
+ * Makes a move for the side to move and hands the turn over
+ * @param  m Move to make
+ * @return   Flipped pieces, needed to take the move back
  */
-BoardNode::BoardNode(Board* board, bool ourSide) :
-                        BoardNode(board, NULL_MOVE(!ourSide)) {
-    nodeCount = 0;
-    maxNodeCount = 0;
-    startTime = time(nullptr);
+unsigned long long BoardNode::makeMove(Move m){
+    stats.nodes += 1;
+    ply++;
+    sideToMove = !sideToMove;
+    return board.doMove(m);
 }
 
 /**
- * Deconstructs node
+ * Takes back a move made with makeMove
+ * @param m     Move to take back
+ * @param flips Flipped pieces returned by makeMove
  */
-BoardNode::~BoardNode(){
-    if (board) delete board;
-    for(int i = 0; i < (int)children.size(); i++){
-        delete children[i];
+void BoardNode::unmakeMove(Move m, unsigned long long flips){
+    board.undoMove(m, flips);
+    ply--;
+    sideToMove = !sideToMove;
+}
+
+/**
+ * Scores moves for the move picker: the hash move first, then the killer
+ * moves of this ply, then by history, with the square priorities breaking
+ * ties. Nothing is searched, so ordering costs no evaluations.
+ * @param moves    Moves to score
+ * @param scores   Set to the score of each move
+ * @param hashMove Best move from the transposition table, or a null move
+ */
+void BoardNode::scoreMoves(MoveList& moves, int* scores, Move hashMove){
+    Move* plyKillers = killers[min(ply, MAX_SEARCH_PLY - 1)];
+    for(int i = 0; i < moves.size(); i++){
+        int square = moves[i].getData() & 0x3f;
+        if(moves[i] == hashMove){
+            scores[i] = HASH_MOVE_SCORE;
+        }
+        else if(moves[i] == plyKillers[0]){
+            scores[i] = KILLER_MOVE_SCORE + 1;
+        }
+        else if(moves[i] == plyKillers[1]){
+            scores[i] = KILLER_MOVE_SCORE;
+        }
+        else{
+            scores[i] = history[sideToMove][square] * 16 + squarePriority[square];
+        }
+    }
+}
+
+/**
+ * Moves the best scored move not yet searched to a place in the list. Most
+ * nodes cut off after a move or two, so the list is never fully sorted.
+ * @param  moves  Moves of the node
+ * @param  scores Scores of the moves, kept in step with them
+ * @param  index  Place to fill; every earlier place has been picked
+ * @return        Move picked
+ */
+Move BoardNode::pickMove(MoveList& moves, int* scores, int index){
+    int best = index;
+    for(int i = index + 1; i < moves.size(); i++){
+        if(scores[i] > scores[best]){
+            best = i;
+        }
+    }
+    if(best != index){
+        moves.swap(index, best);
+        swap(scores[index], scores[best]);
+    }
+    return moves[index];
+}
+
+/**
+ * Records a move that caused a cutoff as a killer move of this ply and in the
+ * history of the side to move
+ * @param m     Move that caused the cutoff
+ * @param depth Depth of the node, deeper cutoffs counting for more
+ */
+void BoardNode::updateOrdering(Move m, int depth){
+    Move* plyKillers = killers[min(ply, MAX_SEARCH_PLY - 1)];
+    if(!(plyKillers[0] == m)){
+        plyKillers[1] = plyKillers[0];
+        plyKillers[0] = m;
+    }
+
+    int* sideHistory = history[sideToMove];
+    sideHistory[m.getData() & 0x3f] += depth * depth;
+    if(sideHistory[m.getData() & 0x3f] > MAX_HISTORY_SCORE){
+        for(int i = 0; i < 64; i++){
+            sideHistory[i] /= 2;
+        }
     }
-    children.clear();
-    nodeCount -= 1;
 }
 
 /**
- * Gets the move that was used to get from the previous board to this one
- * @return Move that was used to get from previous board to this one
+ * Gets the key of the current position in the transposition table. The board
+ * hash only covers the pieces, so the side to move and parity are folded in.
+ * @return Key of the position
+ */
+unsigned long long BoardNode::getKey(){
+    return board.getHash() ^ (sideToMove ? SIDE_KEY : 0x0ULL)
+                           ^ (board.getParity() ? PARITY_KEY : 0x0ULL);
+}
+
+/**
+ * Gets what the searches from this node did since it was constructed
+ * @return Statistics of the searches
+ */
+const SearchStats& BoardNode::getStats(){
+    return stats;
+}
+
+/**
+ * Gets the number of nodes visited since this node was constructed
+ * @return Number of moves made during searches
+ */
+long long BoardNode::getNodeCount(){
+    return stats.nodes;
+}
+
+/**
+ * Gets the number of transposition table lookups since this node was
+ * constructed
+ * @return Number of probes
+ */
+long long BoardNode::getTTProbes(){
+    return stats.ttProbes;
+}
+
+/**
+ * Gets the number of transposition table lookups that found their position
+ * @return Number of hits
+ */
+long long BoardNode::getTTHits(){
+    return stats.ttHits;
+}
+
+/**
+ * Gets the depth of the last iteration getBestChoice completed
+ * @return Completed search depth
+ */
+int BoardNode::getDepthReached(){
+    return depthReached;
+}
+
+/**
+ * Gets the time spent since this node was constructed
+ * @return Elapsed milliseconds
+ */
+int BoardNode::getElapsedMs(){
+    return (int)chrono::duration_cast<chrono::milliseconds>(
+                        chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * Limits the time searches from this node may take. Both limits count from
+ * construction of the node; negative values mean no limit.
+ * @param softMs Time after which no new iteration is started
+ * @param hardMs Time after which a running search is aborted
  */
-Move BoardNode::getMove(){
-    return lastMove;
+void BoardNode::setTimeLimit(int softMs, int hardMs){
+    softTimeLimit = softMs;
+    hardTimeLimit = hardMs;
 }
 
 /**
- * Gets the children of a node
- * @return Vector of node's children
+ * Makes this node a helper in a parallel search. Helpers differ from the main
+ * search in the depths and root move order they try, and stop when the flag is
+ * raised.
+ * @param id   Number of the helper, starting at 1
+ * @param stop Flag raised when the main search has finished
  */
-vector<BoardNode*> BoardNode::getChildren(){
-    return children;
+void BoardNode::setHelper(int id, atomic<bool>* stop){
+    helperId = id;
+    stopFlag = stop;
+}
+
+/**
+ * Makes the search selective with Multi-ProbCut
+ * @param probCut Calibrated parameters, or nullptr for a full-width search
+ */
+void BoardNode::setProbCut(ProbCut* probCut){
+    this->probCut = probCut;
+}
+
+/**
+ * Checks the clock and the stop flag every TIME_CHECK_INTERVAL nodes and
+ * aborts the search once the hard time limit has passed or the flag is raised.
+ * Once aborted, stays aborted.
+ * @return True if the search has been aborted
+ */
+bool BoardNode::isOutOfTime(){
+    if(!isAborted && stats.nodes >= nextTimeCheck){
+        nextTimeCheck = stats.nodes + TIME_CHECK_INTERVAL;
+        if(hardTimeLimit >= 0 && getElapsedMs() > hardTimeLimit){
+            isAborted = true;
+        }
+        if(stopFlag && stopFlag->load(memory_order_relaxed)){
+            isAborted = true;
+        }
+    }
+    return isAborted;
 }
 
 /**
@@ -72,209 +262,387 @@ vector<BoardNode*> BoardNode::getChildren(){
  * @param  heuristic Heuristic function that defines the score of a board
  * @return           Score of the board accounting for future possible moves
  */
-float BoardNode::searchTreeAB(int depth, float alpha, float beta,
-                                    Heuristic* heuristic){
+template<class H>
+float BoardNode::searchTreeAB(int depth, float alpha, float beta, H* heuristic){
+    // Searches started here rather than from getBestChoice
+    if(ply == 0){
+        heuristic->prepareBoard(&board);
+    }
+    if(isOutOfTime()){
+        return 0;
+    }
     if(depth == 0){
-        return heuristic->getScore(board, sideToMove);
+        stats.leafNodes++;
+        stats.evaluations++;
+        return heuristic->getScore(&board, sideToMove);
     }
+    stats.interiorNodes++;
 
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
-    for(int i = 0; i < (int)possibleMoves.size(); i++){
-        children.push_back(new BoardNode(board, possibleMoves[i]));
-        float score = -children[i]->searchTreeAB(depth - 1, -beta, -alpha, heuristic);
+    MoveList possibleMoves = board.possibleMoves(sideToMove);
+    for(int i = 0; i < possibleMoves.size(); i++){
+        unsigned long long flips = makeMove(possibleMoves[i]);
+        float score = -searchTreeAB(depth - 1, -beta, -alpha, heuristic);
+        unmakeMove(possibleMoves[i], flips);
         alpha = max(alpha, score);
-        if(alpha >= beta) break;
+        if(alpha >= beta){
+            stats.addCutoff(i);
+            break;
+        }
+    }
+    return alpha;
+}
+
+/**
+ * Tries to predict the result of a deep search from shallow ones. Each
+ * shallow search is a null window search at the bound its score has to
+ * clear, first for a fail high and then for a fail low.
+ * @param  depth     Depth of the deep search
+ * @param  alpha     The highest overall score found so far
+ * @param  beta      The opponent's best overall score found so far
+ * @param  heuristic Heuristic function that defines the score of a board
+ * @param  tTable    Transposition table to read and store results in
+ * @param  score     Set to the bound the deep search is expected to fail at
+ * @return           True if the deep search can be skipped
+ */
+template<class H>
+bool BoardNode::isProbCut(int depth, float alpha, float beta, H* heuristic,
+                                    TransTable* tTable, float* score){
+    int empties = 64 - board.count(BLACK) - board.count(WHITE);
+    for(int check = 0; check < NUM_PROBCUT_CHECKS; check++){
+        int shallow = ProbCut::getShallowDepth(depth, check);
+        float lower, upper;
+        if(shallow < 0 || !probCut->getCutBounds(empties, depth, shallow,
+                                                alpha, beta, &lower, &upper)){
+            continue;
+        }
+        // Scores lie in [-1, 1], so bounds outside it can never be cleared
+        if(upper < 1 && searchTreePVS(shallow, upper - PVS_WINDOW, upper,
+                                            heuristic, tTable) >= upper){
+            *score = beta;
+            return !isAborted;
+        }
+        if(lower > -1 && searchTreePVS(shallow, lower, lower + PVS_WINDOW,
+                                            heuristic, tTable) <= lower){
+            *score = alpha;
+            return !isAborted;
+        }
+    }
+    return false;
+}
+
+/**
+ * Scores a node one ply above the leaves. All children are scored by one
+ * batched heuristic call, so no move is made and their order does not matter.
+ * A cutoff is counted at the index of the best move in possibleMoves order.
+ * @param  alpha     The highest overall score found so far
+ * @param  beta      The opponent's best overall score found so far
+ * @param  heuristic Heuristic function that defines the score of a board
+ * @param  moves     Moves of the node, in possibleMoves order
+ * @param  bestMove  Set to the best move, if any beat alpha
+ * @return           Score of the node
+ */
+template<class H>
+float BoardNode::scoreFrontier(float alpha, float beta, H* heuristic,
+                                        MoveList& moves, Move* bestMove){
+    float scores[MAX_MOVES];
+    heuristic->getChildScores(&board, sideToMove, board.getMoves(sideToMove),
+                                                                    scores);
+    int numChildren = moves.size();
+    stats.nodes += numChildren;
+    stats.leafNodes += numChildren;
+    stats.evaluations += numChildren;
+    int bestIndex = 0;
+    for(int i = 0; i < numChildren; i++){
+        if(scores[i] > alpha){
+            alpha = scores[i];
+            *bestMove = moves[i];
+            bestIndex = i;
+        }
     }
-    for(int i = 0; i < (int)children.size(); i++){
-        delete children[i];
+    if(alpha >= beta){
+        updateOrdering(*bestMove, 1);
+        stats.addCutoff(bestIndex);
     }
-    children.clear();
-    possibleMoves.clear();
     return alpha;
 }
 
 /**
  * Searches a tree using negamax and PVS pruning to find the heuristic score
- * for this board
+ * for this board. Transposition table entries searched at least as deep end
+ * the search early when their bound allows it, and narrow the window
+ * otherwise.
  * @param  depth     How deep to search the node tree
  * @param  alpha     The highest overall score found so far
  * @param  beta      The opponent's best overall score found so far
  * @param  heuristic Heuristic function that defines the score of a board
+ * @param  tTable    Transposition table to read and store results in
  * @return           Score of the board accounting for future possible moves
  */
+template<class H>
 float BoardNode::searchTreePVS(int depth, float alpha, float beta,
-                                Heuristic* heuristic, TransTableEntry* tTable){
+                                H* heuristic, TransTable* tTable){
+    // Searches started here rather than from getBestChoice
+    if(ply == 0){
+        heuristic->prepareBoard(&board);
+    }
+    if(isOutOfTime()){
+        return 0;
+    }
     if(depth == 0){
-        return heuristic->getScore(board, sideToMove);
+        stats.leafNodes++;
+        stats.evaluations++;
+        return heuristic->getScore(&board, sideToMove);
+    }
+    stats.interiorNodes++;
+
+    float alphaOrig = alpha;
+    TransTableEntry entry;
+    bool isHit = false;
+    if (tTable) {
+        stats.ttProbes++;
+        isHit = tTable->probe(getKey(), &entry);
+        stats.ttHits += isHit;
+    }
+    if (isHit && entry.depth >= depth) {
+        if (entry.bound == BOUND_EXACT) {
+            stats.ttCutoffs++;
+            return entry.score;
+        }
+        if (entry.bound == BOUND_LOWER) {
+            alpha = max(alpha, entry.score);
+        }
+        else if (entry.bound == BOUND_UPPER) {
+            beta = min(beta, entry.score);
+        }
+        if (alpha >= beta) {
+            stats.ttCutoffs++;
+            return entry.score;
+        }
     }
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
 
-    if(depth > 4){
-        possibleMoves = sortMoves(possibleMoves, heuristic, 1);
+    float cutScore;
+    if(probCut && depth >= MIN_PROBCUT_DEPTH &&
+                isProbCut(depth, alpha, beta, heuristic, tTable, &cutScore)){
+        return cutScore;
     }
 
-    if (tTable) {
-        TransTableEntry entry = tTable[board->getHash() % NUM_T_TABLE_ENTRIES];
-        if (entry.hash == board->getHash() && entry.move.getSide() == sideToMove) {
-            //if (depth == 9) cerr << "match" << endl;
-            for(int i = 0; i < (int)possibleMoves.size(); i++){
-                if (possibleMoves[i] == entry.move) {
-                    //if (depth == 9) cerr << "move found at index " << i << " with depth " << (int)entry.depth << endl;
-                    possibleMoves.erase(possibleMoves.begin() + i);
-                    possibleMoves.insert(possibleMoves.begin(), entry.move);
-                    break;
+    MoveList possibleMoves = board.possibleMoves(sideToMove);
+    Move bestMove = possibleMoves[0];
+    // Frontier nodes with an open window are expected to search every child,
+    // so they score them in one batch. Null-window nodes usually cut off
+    // early and make their moves one at a time.
+    bool isOpenWindow = beta - alpha > 2 * PVS_WINDOW;
+    if(depth == 1 && isOpenWindow && !bestMove.isNull()){
+        alpha = scoreFrontier(alpha, beta, heuristic, possibleMoves, &bestMove);
+    }
+    else{
+        int scores[MAX_MOVES];
+        scoreMoves(possibleMoves, scores, isHit ? entry.move : NULL_MOVE(sideToMove));
+
+        bestMove = pickMove(possibleMoves, scores, 0);
+        for(int i = 0; i < possibleMoves.size(); i++){
+            if(i > 0){
+                pickMove(possibleMoves, scores, i);
+            }
+            unsigned long long flips = makeMove(possibleMoves[i]);
+            float score;
+            if(i == 0){
+                score = -searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
+            }
+            else{
+                score = -searchTreePVS(depth - 1, -alpha-PVS_WINDOW, -alpha, heuristic, tTable);
+                if(alpha < score && score < beta){
+                    score = -searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
+                }
+            }
+            unmakeMove(possibleMoves[i], flips);
+            if (score > alpha) {
+                alpha = score;
+                bestMove = possibleMoves[i];
+            }
+            if(alpha >= beta){
+                if(!isAborted){
+                    updateOrdering(possibleMoves[i], depth);
+                    stats.addCutoff(i);
                 }
+                break;
             }
         }
-        else {
-            //if (depth == 9) cerr << entry.hash << " " << (int)entry.depth << endl;
+    }
+
+    if (tTable && !isAborted) {
+        int bound = BOUND_EXACT;
+        if (alpha <= alphaOrig) {
+            bound = BOUND_UPPER;
+        }
+        else if (alpha >= beta) {
+            bound = BOUND_LOWER;
         }
+        tTable->store(getKey(), depth, bestMove, alpha, bound);
     }
 
-    Move bestMove = possibleMoves[0];
-    for(int i = 0; i < (int)possibleMoves.size(); i++){
-        children.push_back(new BoardNode(board, possibleMoves[i]));
+    return alpha;
+}
+
+/**
+ * Searches every root move to a depth. The first move gets the full window
+ * and the rest null windows, re-searched only when they beat the best so far.
+ * @param  depth     Depth to search the root to
+ * @param  alpha     Lower bound of the aspiration window
+ * @param  beta      Upper bound of the aspiration window
+ * @param  heuristic Heuristic function that defines the score of a board
+ * @param  tTable    Transposition table to read and store results in
+ * @param  moves     Root moves, in the order to search them
+ * @param  scores    Set to the score of each move, or the bound it failed at
+ * @param  best      Set to the index of the best move, if any beat alpha
+ * @return           Score of the best move, or the bound it failed at
+ */
+template<class H>
+float BoardNode::searchRoot(int depth, float alpha, float beta, H* heuristic,
+                TransTable* tTable, MoveList& moves, float* scores, int* best){
+    for(int i = 0; i < moves.size(); i++){
+        unsigned long long flips = makeMove(moves[i]);
         float score;
         if(i == 0){
-            score = -children[i]->searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
+            score = -searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
         }
         else{
-            score = -children[i]->searchTreePVS(depth - 1, -alpha-PVS_WINDOW, -alpha, heuristic, tTable);
+            score = -searchTreePVS(depth - 1, -alpha-PVS_WINDOW, -alpha, heuristic, tTable);
             if(alpha < score && score < beta){
-                score = -children[i]->searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
+                score = -searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
             }
         }
-        if (score > alpha) {
+        unmakeMove(moves[i], flips);
+        if(isAborted){
+            break;
+        }
+        scores[i] = score;
+        if(score > alpha){
             alpha = score;
-            bestMove = possibleMoves[i];
+            *best = i;
         }
-        if(alpha >= beta) break;
-    }
-
-    if (tTable) {
-        int index = board->getHash() % NUM_T_TABLE_ENTRIES;
-        if (depth >= tTable[index].depth-2) {
-            tTable[index].hash = board->getHash();
-            tTable[index].depth = depth;
-            tTable[index].move = bestMove;
+        if(alpha >= beta){
+            break;
         }
     }
-
-    for(int i = 0; i < (int)children.size(); i++){
-        delete children[i];
-    }
-    children.clear();
-    possibleMoves.clear();
     return alpha;
 }
 
 /**
- * Searches a tree using a modified minimax algorithm to completely map out
- * winning moveset
- * @param  heuristic Heuristic to describe boardstate. Should give 1 for win and
- *                   -1 for loss.
- * @param  ourSide   Side of the board to scan for winning moveset for
- * @return           Worst case score for this node
+ * Finds the best move to make this round using iterative deepening. The root
+ * moves are kept in one list that each completed iteration reorders by score,
+ * starting from the transposition table's move for the root. From
+ * ASPIRATION_DEPTH on, each iteration searches a narrow window around the
+ * score of the last iteration of the same parity, widening it on the side
+ * that fails until the score lands inside. An exact table score for the root,
+ * left by the last move's search or by pondering, centers the first window.
+ * The result of an iteration cut short by the time limit is thrown away.
+ * Helpers of a parallel search with odd ids only search even depths, and all
+ * helpers swap a different root move to second place, so threads sharing a
+ * table spread out over the tree.
+ * @param  maxDepth  Deepest iteration to search in the node tree
+ * @param  heuristic Heuristic function that defines the score for each position
+ * @param  tTable    Transposition table used for move ordering
+ * @return           The best move found by the last completed iteration
  */
-float BoardNode::searchTreeEndGame(Heuristic* heuristic, bool ourSide){
-    if(maxNodeCount >= 2500000 || difftime(time(nullptr), startTime) > 60){
-        return -1;
+template<class H>
+Move BoardNode::getBestChoice(int maxDepth, H* heuristic, TransTable* tTable){
+    heuristic->prepareBoard(&board);
+    MoveList rootMoves = board.possibleMoves(sideToMove);
+    if(rootMoves.size() == 1){
+        return rootMoves[0];
     }
-
-    if(board->isDone()){
-        return heuristic->getScore(board, ourSide);
+    float scores[MAX_MOVES];
+    float iterationScores[2] = {0, 0};
+    bool hasIterationScore[2] = {false, false};
+    TransTableEntry entry;
+    if(tTable && tTable->probe(getKey(), &entry)){
+        rootMoves.moveToFront(entry.move);
+        // The last move's search or pondering may have scored this position
+        if(entry.bound == BOUND_EXACT){
+            iterationScores[entry.depth % 2] = entry.score;
+            hasIterationScore[entry.depth % 2] = true;
+        }
     }
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
-
-    if(sideToMove == ourSide){
-        for(int i = 0; i < (int)possibleMoves.size(); i++){
-            BoardNode *testNode = new BoardNode(board, possibleMoves[i]);
-            float score = testNode->searchTreeEndGame(heuristic, ourSide);
-            if(score > 0){
-                children.push_back(testNode);
-                return 1;
+
+    int depthStep = 1 + helperId % 2;
+    for(int depth = depthStep; depth <= maxDepth; depth += depthStep){
+        if(helperId && rootMoves.size() > 2){
+            rootMoves.swap(1, 1 + helperId % (rootMoves.size() - 1));
+        }
+
+        float window = ASPIRATION_WINDOW;
+        float center = iterationScores[depth % 2];
+        bool isAspiration = depth >= ASPIRATION_DEPTH && hasIterationScore[depth % 2];
+        float alpha = isAspiration ? center - window : -numeric_limits<float>::max();
+        float beta = isAspiration ? center + window : numeric_limits<float>::max();
+        float score;
+        int best = -1;
+        while(true){
+            int windowBest = -1;
+            score = searchRoot(depth, alpha, beta, heuristic, tTable, rootMoves,
+                                                        scores, &windowBest);
+            if(isAborted){
+                break;
+            }
+            if(windowBest >= 0){
+                best = windowBest;
+            }
+            if(score > alpha && score < beta){
+                break;
+            }
+            // A move that fails high is searched first in the wider window.
+            // Scores lie in [-1, 1], so a window past that is a full window.
+            if(score >= beta){
+                rootMoves.swap(0, best);
+                swap(scores[0], scores[best]);
+                best = 0;
+            }
+            window *= ASPIRATION_GROWTH;
+            if(score <= alpha){
+                alpha = center - window < -1 ? -numeric_limits<float>::max()
+                                             : center - window;
             }
             else{
-                delete testNode;
+                beta = center + window > 1 ? numeric_limits<float>::max()
+                                           : center + window;
             }
         }
-        return -1;
-    }
-    else{
-        for(int i = 0; i < (int)possibleMoves.size(); i++){
-            BoardNode *testNode = new BoardNode(board, possibleMoves[i]);
-            float score = testNode->searchTreeEndGame(heuristic, ourSide);
-            children.push_back(testNode);
-            if(score <= 0){
-                for(int j = 0; j <= i; j++){
-                    delete children[j];
-                }
-                children.clear();
-                return -1;
-            }
+        if(isAborted){
+            break;
         }
-        return 1;
-    }
-
-}
-
-
-/**
- * Finds the best move to make this round using minimax and A/B pruning
- * @param  depth     Depth to search in the node tree
- * @param  heuristic Heuristic function that defines the score for each position
- * @param  ourSide   The side that you are playing on. Passed into heuristic function.
- * @return           The most optimal move based on the heuristic function
- */
-Move BoardNode::getBestChoice(int depth, Heuristic* heuristic,
-                                        TransTableEntry* tTable){
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
-    if(possibleMoves.size() == 1){
-        return possibleMoves[0];
-    }
-    for(int i = 0; i < (int)possibleMoves.size(); i++){
-        children.push_back(new BoardNode(board, possibleMoves[i]));
-    }
-    float alpha = -numeric_limits<float>::max();
-    float beta = numeric_limits<float>::max();
 
-    Move ret = NULL_MOVE(sideToMove);
-    for(int i = 0; i < (int)children.size(); i++){
-        float score = -children[i]->searchTreePVS(depth - 1, -beta, -alpha, heuristic, tTable);
-        if(score > alpha){
-            alpha = score;
-            ret = children[i]->getMove();
+        // Best move first, then the rest by the score or bound they got
+        rootMoves.swap(0, best);
+        swap(scores[0], scores[best]);
+        for(int i = 2; i < rootMoves.size(); i++){
+            for(int j = i; j > 1 && scores[j] > scores[j-1]; j--){
+                swap(scores[j], scores[j-1]);
+                rootMoves.swap(j, j-1);
+            }
+        }
+        iterationScores[depth % 2] = score;
+        hasIterationScore[depth % 2] = true;
+        if(tTable){
+            tTable->store(getKey(), depth, rootMoves[0], score, BOUND_EXACT);
+        }
+        depthReached = depth;
+        stats.addIteration(depth, getElapsedMs());
+        if(softTimeLimit >= 0 && getElapsedMs() > softTimeLimit){
+            break;
         }
     }
-    for(int i = 0; i < (int)children.size(); i++){
-        delete children[i];
-    }
-    children.clear();
-    return ret;
+    return rootMoves[0];
 }
 
-/**
- * Sorts a vector of moves by predicted heuristic value through a short negamax scan
- * @param moves     Vector of moves to sort
- * @param heuristic Heuristic function to use while sorting
- * @param depth     How deep the search will go
- * @return          The sorted vector of moves
- */
-vector<Move> BoardNode::sortMoves(vector<Move> moves, Heuristic* heuristic,
-                                            int depth){
-    vector<pair<float, int>> indexScores;
-    float alpha = -numeric_limits<float>::max();
-    float beta = numeric_limits<float>::max();
-
-    for(int i = 0; i < (int)moves.size(); i++){
-        BoardNode node = BoardNode(board, moves[i]);
-        indexScores.push_back(make_pair(node.searchTreeAB(depth, alpha, beta, heuristic), i));
-    }
-    std::sort(indexScores.begin(), indexScores.end());
-    vector<Move> sorted;
-    for(int i = 0; i < (int)indexScores.size(); i++){
-        sorted.push_back(moves[indexScores[i].second]);
-    }
+#define INSTANTIATE_SEARCH(H) \
+    template Move BoardNode::getBestChoice<H>(int, H*, TransTable*); \
+    template float BoardNode::searchTreeAB<H>(int, float, float, H*); \
+    template float BoardNode::searchTreePVS<H>(int, float, float, H*, TransTable*); \
+    template float BoardNode::scoreFrontier<H>(float, float, H*, MoveList&, Move*); \
+    template float BoardNode::searchRoot<H>(int, float, float, H*, TransTable*, \
+                                                    MoveList&, float*, int*);
 
-    return sorted;
-}
+INSTANTIATE_SEARCH(LinearHeuristic)
+INSTANTIATE_SEARCH(TimeHeuristic)
+INSTANTIATE_SEARCH(PatternHeuristic)
@@ -5,37 +5,108 @@
 #include <iostream>
 #include <limits>
 #include <algorithm>
-#include <time.h>
+#include <chrono>
+#include <atomic>
+#include <cstring>
 #include "common.hpp"
 #include "board.hpp"
 #include "heuristic.hpp"
+#include "transTable.hpp"
+#include "probCut.hpp"
+#include "searchStats.hpp"
 using namespace std;
 
 #define PVS_WINDOW 0.0001
 
+#define TIME_CHECK_INTERVAL 1024
+
+// Iterations at least this deep search a window around the last score
+#define ASPIRATION_DEPTH 3
+// Half width of the first aspiration window, and how much each fail widens it
+#define ASPIRATION_WINDOW 0.02
+#define ASPIRATION_GROWTH 4
+
+// Plies with their own killer moves; deeper plies share the last ones
+#define MAX_SEARCH_PLY 64
+#define NUM_KILLERS 2
+// Ordering scores of the hash move and killer moves, above any history score
+#define HASH_MOVE_SCORE (1 << 30)
+#define KILLER_MOVE_SCORE (1 << 29)
+// History scores are halved once one passes this, so old cutoffs fade
+#define MAX_HISTORY_SCORE (1 << 24)
+
+// Folded into transposition table keys, since the board hash only covers pieces
+#define SIDE_KEY 0x9e3779b97f4a7c15ULL
+#define PARITY_KEY 0xc2b2ae3d27d4eb4fULL
+
+/**
+ * Searches the game tree below a position. The position is held by value and
+ * every move is made and taken back in place, so no search allocates. The
+ * search is instantiated for each concrete heuristic in boardNode.cpp, so
+ * leaf evaluations are direct, inlined calls.
+ */
 class BoardNode{
 
 private:
-    Board* board;
-    Move lastMove;
+    Board board;
     bool sideToMove;
-    vector<BoardNode*> children;
+    SearchStats stats;
+    chrono::steady_clock::time_point startTime;
+    int softTimeLimit;
+    int hardTimeLimit;
+    int depthReached;
+    int helperId;
+    atomic<bool>* stopFlag;
+    bool isAborted;
+    // Node count at which the clock is next checked; frontier nodes add
+    // several nodes at once, so counts are not checked for multiples
+    long long nextTimeCheck;
+    ProbCut* probCut;
+    // Distance from the root of the search
+    int ply;
+    // Latest moves to cause a cutoff at each ply
+    Move killers[MAX_SEARCH_PLY][NUM_KILLERS];
+    // Cutoffs caused by each move of each side, weighted by depth
+    int history[2][64];
+
+    static const int squarePriority[64];
 
+    unsigned long long makeMove(Move m);
+    void unmakeMove(Move m, unsigned long long flips);
+    bool isOutOfTime();
+    unsigned long long getKey();
+    template<class H>
+    bool isProbCut(int depth, float alpha, float beta, H* heuristic,
+                TransTable* tTable, float* score);
+    void scoreMoves(MoveList& moves, int* scores, Move hashMove);
+    Move pickMove(MoveList& moves, int* scores, int index);
+    void updateOrdering(Move m, int depth);
+    template<class H>
+    float scoreFrontier(float alpha, float beta, H* heuristic,
+                MoveList& moves, Move* bestMove);
+    template<class H>
+    float searchRoot(int depth, float alpha, float beta, H* heuristic,
+                TransTable* tTable, MoveList& moves, float* scores, int* best);
 
 public:
     BoardNode(Board* board, bool ourSide);
-    BoardNode(Board* b, Move m);
     ~BoardNode();
-    Move getBestChoice(int depth, Heuristic* heuristic, TransTableEntry* tTable);
-    float searchTreeAB(int depth, float alpha, float beta,
-                Heuristic* heuristic);
+    void setTimeLimit(int softMs, int hardMs);
+    void setHelper(int id, atomic<bool>* stop);
+    void setProbCut(ProbCut* probCut);
+    template<class H>
+    Move getBestChoice(int maxDepth, H* heuristic, TransTable* tTable);
+    template<class H>
+    float searchTreeAB(int depth, float alpha, float beta, H* heuristic);
+    template<class H>
     float searchTreePVS(int depth, float alpha, float beta,
-                Heuristic* heuristic, TransTableEntry* tTable);
-    float searchTreeEndGame(Heuristic* heuristic, bool ourSide);
-    vector<Move> sortMoves(vector<Move> moves, Heuristic* heuristic,
-                                                    int depth);
-    Move getMove();
-    vector<BoardNode*> getChildren();
+                H* heuristic, TransTable* tTable);
+    const SearchStats& getStats();
+    long long getNodeCount();
+    long long getTTProbes();
+    long long getTTHits();
+    int getDepthReached();
+    int getElapsedMs();
 
 };
 
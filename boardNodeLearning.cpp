@@ -74,8 +74,8 @@ float BoardNodeLearning::searchTreeAB(int depth, float alpha, float beta,
         return heuristic->getScore(board, sideToMove);
     }
 
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
-    for(int i = 0; i < (int)possibleMoves.size(); i++){
+    MoveList possibleMoves = board->possibleMoves(sideToMove);
+    for(int i = 0; i < possibleMoves.size(); i++){
         children.push_back(new BoardNodeLearning(board, possibleMoves[i]));
         float score = -children[i]->searchTreeAB(depth - 1, -beta, -alpha, heuristic);
         alpha = max(alpha, score);
@@ -85,7 +85,6 @@ float BoardNodeLearning::searchTreeAB(int depth, float alpha, float beta,
         delete children[i];
     }
     children.clear();
-    possibleMoves.clear();
     return alpha;
 }
 
@@ -105,12 +104,12 @@ float BoardNodeLearning::searchTreePVS(int depth, float alpha, float beta,
         principalBoard = board->copy();
         return heuristic->getScore(board, sideToMove);
     }
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
+    MoveList possibleMoves = board->possibleMoves(sideToMove);
 
     if(depth > 4){
-        possibleMoves = sortMoves(possibleMoves, heuristic, 1);
+        sortMoves(possibleMoves, heuristic, 1);
     }
-    for(int i = 0; i < (int)possibleMoves.size(); i++){
+    for(int i = 0; i < possibleMoves.size(); i++){
         children.push_back(new BoardNodeLearning(board, possibleMoves[i]));
         float score;
         if(i == 0){
@@ -135,7 +134,6 @@ float BoardNodeLearning::searchTreePVS(int depth, float alpha, float beta,
         delete children[i];
     }
     children.clear();
-    possibleMoves.clear();
     return alpha;
 }
 
@@ -147,8 +145,8 @@ float BoardNodeLearning::searchTreePVS(int depth, float alpha, float beta,
  * @return           The most optimal move based on the heuristic function
  */
 Move BoardNodeLearning::getBestChoice(int depth, Heuristic* heuristic){
-    vector<Move> possibleMoves = board->possibleMoves(sideToMove);
-    for(int i = 0; i < (int)possibleMoves.size(); i++){
+    MoveList possibleMoves = board->possibleMoves(sideToMove);
+    for(int i = 0; i < possibleMoves.size(); i++){
         children.push_back(new BoardNodeLearning(board, possibleMoves[i]));
     }
     float alpha = -numeric_limits<float>::max();
@@ -172,27 +170,27 @@ Move BoardNodeLearning::getBestChoice(int depth, Heuristic* heuristic){
 }
 
 /**
- * Sorts a vector of moves by predicted heuristic value through a short negamax scan
- * @param moves     Vector of moves to sort
+ * Sorts a list of moves in place by predicted heuristic value through a short
+ * negamax scan
+ * @param moves     List of moves to sort
  * @param heuristic Heuristic function to use while sorting
  * @param depth     How deep the search will go
- * @return          The sorted vector of moves
  */
-vector<Move> BoardNodeLearning::sortMoves(vector<Move> moves, Heuristic* heuristic,
-                                            int depth){
-    vector<pair<float, int>> indexScores;
+void BoardNodeLearning::sortMoves(MoveList& moves, Heuristic* heuristic, int depth){
+    float scores[MAX_MOVES];
     float alpha = -numeric_limits<float>::max();
     float beta = numeric_limits<float>::max();
 
-    for(int i = 0; i < (int)moves.size(); i++){
+    for(int i = 0; i < moves.size(); i++){
         BoardNodeLearning node = BoardNodeLearning(board, moves[i]);
-        indexScores.push_back(make_pair(node.searchTreeAB(depth, alpha, beta, heuristic), i));
-    }
-    std::sort(indexScores.begin(), indexScores.end());
-    vector<Move> sorted;
-    for(int i = 0; i < (int)indexScores.size(); i++){
-        sorted.push_back(moves[indexScores[i].second]);
+        scores[i] = node.searchTreeAB(depth, alpha, beta, heuristic);
     }
 
-    return sorted;
+    // Insertion sort keeps moves with equal scores in their original order
+    for(int i = 1; i < moves.size(); i++){
+        for(int j = i; j > 0 && scores[j] < scores[j-1]; j--){
+            swap(scores[j], scores[j-1]);
+            moves.swap(j, j-1);
+        }
+    }
 }
@@ -31,8 +31,7 @@ public:
                 Heuristic* heuristic);
     float searchTreePVS(int depth, float alpha, float beta,
                 Heuristic* heuristic);
-    vector<Move> sortMoves(vector<Move> moves, Heuristic* heuristic,
-                                                    int depth);
+    void sortMoves(MoveList& moves, Heuristic* heuristic, int depth);
     Move getMove();
     vector<BoardNodeLearning*> getChildren();
     Board* getPrincipalBoard();
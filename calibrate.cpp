@@ -0,0 +1,192 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <limits>
+#include "common.hpp"
+#include "board.hpp"
+#include "boardNode.hpp"
+#include "transTable.hpp"
+#include "probCut.hpp"
+#include "linearHeuristic.hpp"
+#include "timeHeuristic.hpp"
+#include "patternHeuristic.hpp"
+
+#define DEFAULT_WEIGHTS "weights/handmade.weights"
+#define DEFAULT_POSITIONS 1500
+#define SEED 2018
+
+// Deepest search each position is scored at
+#define CALIBRATE_DEPTH 10
+#define CALIBRATE_T_TABLE_ENTRIES (1 << 20)
+
+#define OPENING_MOVES 8
+#define PLAY_DEPTH 2
+// Percent of moves after the opening that are played at random
+#define RANDOM_MOVE_RATE 10
+// Positions are recorded until this many empties; the solver takes over later
+#define MIN_EMPTIES 14
+
+typedef struct {
+    int empties;
+    float scores[CALIBRATE_DEPTH + 1];
+} Sample;
+
+/**
+ * Plays a game of random opening moves, then a shallow search mixed with
+ * random moves, and keeps every position until MIN_EMPTIES empties
+ */
+template<class H>
+static void playGame(vector<Board>& boards, vector<bool>& sides,
+                            mt19937& generator, H* heuristic){
+    Board board;
+    bool side = BLACK;
+    int empties = 60;
+    while(!board.isDone() && empties >= MIN_EMPTIES){
+        MoveList moves = board.possibleMoves(side);
+        if(!moves[0].isNull()){
+            boards.push_back(board);
+            sides.push_back(side);
+        }
+        Move move = moves[0];
+        if(empties > 60 - OPENING_MOVES || (int)(generator() % 100) < RANDOM_MOVE_RATE){
+            move = moves[generator() % moves.size()];
+        }
+        else if(moves.size() > 1){
+            BoardNode root(&board, side);
+            move = root.getBestChoice(PLAY_DEPTH, heuristic, nullptr);
+        }
+        board.doMove(move);
+        side = !side;
+        empties = 64 - board.count(BLACK) - board.count(WHITE);
+    }
+}
+
+/**
+ * Scores positions from self-play at every depth up to CALIBRATE_DEPTH with
+ * a full-width search
+ */
+template<class H>
+static vector<Sample> collectSamples(H* heuristic, int numPositions){
+    mt19937 generator(SEED);
+    vector<Board> boards;
+    vector<bool> sides;
+    while((int)boards.size() < numPositions * 4){
+        playGame(boards, sides, generator, heuristic);
+    }
+
+    // Spread the positions over whole games rather than taking a few games
+    vector<Sample> samples;
+    TransTable tTable(CALIBRATE_T_TABLE_ENTRIES);
+    for(int i = 0; i < numPositions; i++){
+        int index = generator() % boards.size();
+        Sample s;
+        s.empties = 64 - boards[index].count(BLACK) - boards[index].count(WHITE);
+        tTable.newSearch();
+        BoardNode root(&boards[index], sides[index]);
+        for(int depth = 0; depth <= CALIBRATE_DEPTH; depth++){
+            s.scores[depth] = root.searchTreePVS(depth,
+                        -numeric_limits<float>::max(),
+                        numeric_limits<float>::max(), heuristic, &tTable);
+        }
+        samples.push_back(s);
+        if(i % 50 == 0){
+            cerr << "\rPosition " << i << "/" << numPositions;
+        }
+    }
+    cerr << "\rScored " << numPositions << " positions" << endl;
+    return samples;
+}
+
+// Fits Multi-ProbCut parameters for a heuristic. Positions from self-play are
+// searched to every depth, and the deep score of each pair of depths is fitted
+// as a linear function of the shallow one for each stage of the game. The
+// parameters are saved next to the weights, which the player and the bench
+// pick up.
+int main(int argc, char *argv[]) {
+    string weightName = argc > 1 ? argv[1] : DEFAULT_WEIGHTS;
+    int numPositions = argc > 2 ? atoi(argv[2]) : DEFAULT_POSITIONS;
+
+    ifstream ifile(weightName);
+    string heuristicType;
+    if(!(ifile >> heuristicType)){
+        cerr << "Error opening file: " << weightName << endl;
+        return 1;
+    }
+    ifile.close();
+
+    vector<Sample> samples;
+    if(heuristicType == "time"){
+        TimeHeuristic heuristic(weightName.c_str());
+        samples = collectSamples(&heuristic, numPositions);
+    }
+    else if(heuristicType == "pattern"){
+        PatternHeuristic heuristic(weightName.c_str());
+        samples = collectSamples(&heuristic, numPositions);
+    }
+    else{
+        LinearHeuristic heuristic(weightName.c_str());
+        samples = collectSamples(&heuristic, numPositions);
+    }
+
+    ProbCut probCut;
+    for(int stage = 0; stage < NUM_PROBCUT_STAGES; stage++){
+        vector<Sample*> stageSamples;
+        for(int i = 0; i < (int)samples.size(); i++){
+            if(ProbCut::getStage(samples[i].empties) == stage){
+                stageSamples.push_back(&samples[i]);
+            }
+        }
+        int n = stageSamples.size();
+        if(n < MIN_PROBCUT_SAMPLES){
+            continue;
+        }
+
+        for(int deep = 1; deep <= CALIBRATE_DEPTH; deep++){
+            for(int shallow = 0; shallow < deep; shallow++){
+                double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+                for(int i = 0; i < n; i++){
+                    double x = stageSamples[i]->scores[shallow];
+                    double y = stageSamples[i]->scores[deep];
+                    sumX += x;
+                    sumY += y;
+                    sumXX += x * x;
+                    sumXY += x * y;
+                }
+                double varX = sumXX / n - (sumX / n) * (sumX / n);
+                if(varX <= 0){
+                    continue;
+                }
+                double slope = (sumXY / n - (sumX / n) * (sumY / n)) / varX;
+                double intercept = sumY / n - slope * sumX / n;
+                double sumErrors = 0;
+                for(int i = 0; i < n; i++){
+                    double error = stageSamples[i]->scores[deep] - (slope *
+                                stageSamples[i]->scores[shallow] + intercept);
+                    sumErrors += error * error;
+                }
+                double sigma = sqrt(sumErrors / (n - 2));
+                probCut.setFit(stage, deep, shallow, slope, intercept, sigma);
+            }
+        }
+
+        int shallow = ProbCut::getShallowDepth(CALIBRATE_DEPTH, NUM_PROBCUT_CHECKS - 1);
+        cerr << "Stage " << stage << ": " << n << " positions" << endl;
+        cerr << "  depth " << CALIBRATE_DEPTH << " from " << shallow << ": ";
+        float lower, upper;
+        if(probCut.getCutBounds(stage * PROBCUT_STAGE_EMPTIES, CALIBRATE_DEPTH,
+                                    shallow, 0, 0, &lower, &upper)){
+            cerr << "cut outside [" << lower << ", " << upper << "]" << endl;
+        }
+        else{
+            cerr << "not calibrated" << endl;
+        }
+    }
+
+    string outName = weightName.substr(0, weightName.rfind('.')) + ".probcut";
+    probCut.save(outName.c_str());
+    cerr << "Saved " << outName << endl;
+    return 0;
+}
@@ -23,6 +23,9 @@ public:
 
     Move(bool side) : Move((unsigned char)(side ? 0xc0 : 0x40)) {}
 
+    // Leaves the move unset, for arrays that are filled before use
+    Move() {}
+
     ~Move() {}
 
     int getX() { return (int)((move >> 3) & 0x07); }
@@ -31,6 +34,10 @@ public:
 
     bool isNull() { return (bool)(move & 0x40); }
 
+    // Raw encoding, for packing moves into table entries
+    unsigned char getData() { return move; }
+    static Move fromData(unsigned char data) { return Move(data); }
+
     bool operator == (const Move &Ref) const
         {
             return(move == Ref.move);
@@ -39,13 +46,63 @@ public:
 };
 
 
+// Upper bound on the moves in any position, with room to spare
+#define MAX_MOVES 64
+
+/**
+ * Fixed-capacity list of moves that lives on the stack
+ */
+class MoveList {
+
+private:
+    Move moves[MAX_MOVES];
+    int length;
+
+public:
+    MoveList() : length(0) {}
+
+    int size() { return length; }
+    void push(Move m) { moves[length++] = m; }
+
+    Move& operator [] (int i) { return moves[i]; }
+
+    void swap(int i, int j)
+        {
+            Move temp = moves[i];
+            moves[i] = moves[j];
+            moves[j] = temp;
+        }
+
+    /**
+     * Puts a move at the front by swapping it with the current front move
+     * @return True if the move was in the list
+     */
+    bool moveToFront(Move m)
+        {
+            for(int i = 0; i < length; i++){
+                if(moves[i] == m){
+                    swap(0, i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+};
+
+
 #define NUM_T_TABLE_ENTRIES 10000000
 //10000000
 
+// What a stored score says about the true score of a position
+enum Bound {BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT};
+
 typedef struct {
     unsigned long long hash = 0x0ULL;
     char depth = 0;
     Move move = NULL_MOVE(BLACK);
+    float score = 0;
+    char bound = BOUND_NONE;
 } TransTableEntry;
 
 #endif
@@ -0,0 +1,575 @@
+#include "endgameSolver.hpp"
+
+#define BIT(pos) (0x1ULL << (pos))
+#define CORNERS 0x8100000000000081ULL
+
+// Quadrants of the board, used for parity ordering
+static const unsigned long long quadrants[4] = {
+    0xf0f0f0f000000000ULL, 0x0f0f0f0f00000000ULL,
+    0x00000000f0f0f0f0ULL, 0x000000000f0f0f0fULL
+};
+
+/**
+ * Constructs a solver with an empty hash table
+ * @param numThreads Threads each solve runs on
+ */
+EndgameSolver::EndgameSolver(int numThreads){
+    table = new SolveEntry[NUM_SOLVE_TABLE_ENTRIES];
+    for(int i = 0; i < NUM_SOLVE_TABLE_ENTRIES; i++){
+        table[i].own.store(0x0ULL, memory_order_relaxed);
+        table[i].opp.store(0x0ULL, memory_order_relaxed);
+        table[i].data.store(0x0ULL, memory_order_relaxed);
+    }
+    this->numThreads = max(numThreads, 1);
+    nodeCount = 0;
+    hardTimeLimit = -1;
+    isAborted = false;
+    numIdle = 0;
+    isDone = false;
+    startTime = chrono::steady_clock::now();
+}
+
+/**
+ * Deconstructs the solver
+ */
+EndgameSolver::~EndgameSolver(){
+    delete[] table;
+}
+
+/**
+ * Limits the time a call to solve may take
+ * @param hardMs Time after which the solve is aborted, negative for no limit
+ */
+void EndgameSolver::setTimeLimit(int hardMs){
+    hardTimeLimit = hardMs;
+}
+
+/**
+ * Determines whether the last solve ran out of time
+ * @return True if the last solve was aborted
+ */
+bool EndgameSolver::wasAborted(){
+    return isAborted.load();
+}
+
+/**
+ * Gets the number of positions the last solve visited, over all threads
+ * @return Number of nodes searched
+ */
+long long EndgameSolver::getNodeCount(){
+    return nodeCount.load();
+}
+
+/**
+ * Scores a finished game. Empty squares go to the winner.
+ * @param  own Pieces of the side to score for
+ * @param  opp Pieces of the opponent
+ * @return     Final disc difference
+ */
+int EndgameSolver::finalScore(unsigned long long own, unsigned long long opp){
+    int ownCount = __builtin_popcountll(own);
+    int oppCount = __builtin_popcountll(opp);
+    int empties = 64 - ownCount - oppCount;
+    int diff = ownCount - oppCount;
+    if(diff > 0){
+        return diff + empties;
+    }
+    if(diff < 0){
+        return diff - empties;
+    }
+    return 0;
+}
+
+/**
+ * Checks the clock every SOLVE_TIME_CHECK_INTERVAL nodes of a thread and
+ * aborts the solve once the hard time limit has passed. A thread also stops
+ * when a split point it is searching under has cut off.
+ * @param  w Thread to check
+ * @return   True if the thread's search is no longer needed
+ */
+bool EndgameSolver::isStopped(Worker* w){
+    if(!w->isStopped && w->nodeCount % SOLVE_TIME_CHECK_INTERVAL == 0){
+        if(hardTimeLimit >= 0){
+            int elapsed = (int)chrono::duration_cast<chrono::milliseconds>(
+                            chrono::steady_clock::now() - startTime).count();
+            if(elapsed > hardTimeLimit){
+                isAborted.store(true);
+            }
+        }
+        w->isStopped = isAborted.load(memory_order_relaxed) || isCutoff(w->splitPoint);
+    }
+    return w->isStopped;
+}
+
+/**
+ * Determines whether a split point or any split point above it has cut off
+ * @param  sp Innermost split point, or nullptr
+ * @return    True if the search below sp is no longer needed
+ */
+bool EndgameSolver::isCutoff(SplitPoint* sp){
+    for(; sp; sp = sp->parent){
+        if(sp->isCutoff.load(memory_order_relaxed)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Finds the table entry for a position
+ * @param  bounds Set to what the entry proved about the position
+ * @return        True if the position is stored
+ */
+bool EndgameSolver::probe(unsigned long long own, unsigned long long opp,
+                                                SolveBounds* bounds){
+    unsigned long long key = own * 0x9e3779b97f4a7c15ULL ^ opp * 0xc2b2ae3d27d4eb4fULL;
+    SolveEntry* bucket = &table[((key ^ (key >> 29)) % (NUM_SOLVE_TABLE_ENTRIES / 2)) * 2];
+    for(int i = 0; i < 2; i++){
+        unsigned long long data = bucket[i].data.load(memory_order_relaxed);
+        if(bucket[i].own.load(memory_order_relaxed) == own
+                && bucket[i].opp.load(memory_order_relaxed) == opp
+                && data && (data >> 32) == (key >> 32)){
+            bounds->lower = (int)(data & 0xff) - SOLVE_WINDOW;
+            bounds->upper = (int)((data >> 8) & 0xff) - SOLVE_WINDOW;
+            bounds->empties = (int)((data >> 16) & 0xff);
+            bounds->move = (int)((data >> 24) & 0xff);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Stores the bounds a search proved on a position's score. Bounds are true for
+ * the position whatever window finds them, so they stay valid across solves,
+ * and two threads merging bounds at once can only lose some of them.
+ * @param empties Number of empty squares, the depth of the search
+ * @param alpha   Lower end of the window that was searched
+ * @param beta    Upper end of the window that was searched
+ * @param score   Fail-soft result of the search
+ * @param move    Bit position of the best move
+ */
+void EndgameSolver::store(unsigned long long own, unsigned long long opp,
+            int empties, int alpha, int beta, int score, int move){
+    unsigned long long key = own * 0x9e3779b97f4a7c15ULL ^ opp * 0xc2b2ae3d27d4eb4fULL;
+    SolveEntry* bucket = &table[((key ^ (key >> 29)) % (NUM_SOLVE_TABLE_ENTRIES / 2)) * 2];
+
+    SolveBounds bounds;
+    SolveEntry* entry;
+    if(probe(own, opp, &bounds)){
+        entry = bucket[0].own.load(memory_order_relaxed) == own
+             && bucket[0].opp.load(memory_order_relaxed) == opp ? &bucket[0] : &bucket[1];
+    }
+    else{
+        int firstEmpties = (int)((bucket[0].data.load(memory_order_relaxed) >> 16) & 0xff);
+        entry = (firstEmpties <= empties) ? &bucket[0] : &bucket[1];
+        bounds.lower = -SOLVE_WINDOW;
+        bounds.upper = SOLVE_WINDOW;
+    }
+    if(score > alpha){
+        bounds.lower = max(bounds.lower, score);
+    }
+    if(score < beta){
+        bounds.upper = min(bounds.upper, score);
+    }
+
+    unsigned long long data = (unsigned long long)(bounds.lower + SOLVE_WINDOW)
+                            | (unsigned long long)(bounds.upper + SOLVE_WINDOW) << 8
+                            | (unsigned long long)empties << 16
+                            | (unsigned long long)move << 24
+                            | (key >> 32) << 32;
+    entry->own.store(own, memory_order_relaxed);
+    entry->opp.store(opp, memory_order_relaxed);
+    entry->data.store(data, memory_order_relaxed);
+}
+
+/**
+ * Solves a position with a single empty square
+ * @param  empty The empty square
+ * @return       Final disc difference for the side to move
+ */
+int EndgameSolver::searchLast(Worker* w, unsigned long long own,
+                    unsigned long long opp, unsigned long long empty){
+    w->nodeCount++;
+    int pos = __builtin_ctzll(empty);
+    unsigned long long flips = Board::findFlips(pos, own, opp);
+    if(flips){
+        return finalScore(own ^ flips ^ empty, opp ^ flips);
+    }
+    flips = Board::findFlips(pos, opp, own);
+    if(flips){
+        return finalScore(own ^ flips, opp ^ flips ^ empty);
+    }
+    return finalScore(own, opp);
+}
+
+/**
+ * Orders moves fastest-first: the moves that leave the opponent the fewest
+ * replies come first, corners break ties and the hash move goes before all.
+ * @param  moves    Grid of bits with the legal moves set
+ * @param  hashMove Bit position of the hash move, or -1
+ * @param  order    Filled with the bit positions of the moves, in order
+ * @return          Number of moves
+ */
+int EndgameSolver::orderMoves(unsigned long long own, unsigned long long opp,
+                    unsigned long long moves, int hashMove, int* order){
+    int keys[MAX_MOVES];
+    int count = 0;
+    while(moves){
+        int pos = __builtin_ctzll(moves);
+        moves &= moves - 1;
+
+        int key;
+        if(pos == hashMove){
+            key = -1000;
+        }
+        else{
+            unsigned long long flips = Board::findFlips(pos, own, opp);
+            unsigned long long replies = Board::findMoves(opp ^ flips, own ^ flips ^ BIT(pos));
+            key = 4 * (__builtin_popcountll(replies) + __builtin_popcountll(replies & CORNERS));
+            if(BIT(pos) & CORNERS){
+                key -= 2;
+            }
+        }
+
+        int i = count++;
+        for(; i > 0 && keys[i-1] > key; i--){
+            keys[i] = keys[i-1];
+            order[i] = order[i-1];
+        }
+        keys[i] = key;
+        order[i] = pos;
+    }
+    return count;
+}
+
+/**
+ * Searches a position to the end of the game with negamax and fail-soft
+ * alpha-beta pruning
+ * @param  w      Thread doing the search
+ * @param  alpha  Lowest score still of interest
+ * @param  beta   Score at which the opponent will avoid this position
+ * @param  passed True if the opponent just passed
+ * @return        Final disc difference for the side to move, or a bound on it
+ *                outside the window
+ */
+int EndgameSolver::search(Worker* w, unsigned long long own,
+            unsigned long long opp, int alpha, int beta, bool passed){
+    if(isStopped(w)){
+        return 0;
+    }
+    unsigned long long empty = ~(own | opp);
+    int empties = __builtin_popcountll(empty);
+    if(empties == 1){
+        return searchLast(w, own, opp, empty);
+    }
+    w->nodeCount++;
+    if(empties == 0){
+        return finalScore(own, opp);
+    }
+
+    unsigned long long moves = Board::findMoves(own, opp);
+    if(!moves){
+        if(passed){
+            return finalScore(own, opp);
+        }
+        return -search(w, opp, own, -beta, -alpha, true);
+    }
+
+    // Near the end, play into regions with an odd number of empties first,
+    // hoping to get the last move there
+    if(empties <= PARITY_EMPTIES){
+        int best = -SOLVE_WINDOW;
+        unsigned long long parity = 0x0ULL;
+        for(int i = 0; i < 4; i++){
+            if(__builtin_popcountll(empty & quadrants[i]) & 1){
+                parity |= quadrants[i];
+            }
+        }
+        unsigned long long sets[2] = {moves & parity, moves & ~parity};
+        for(int i = 0; i < 2; i++){
+            while(sets[i]){
+                int pos = __builtin_ctzll(sets[i]);
+                sets[i] &= sets[i] - 1;
+                unsigned long long flips = Board::findFlips(pos, own, opp);
+                int score = -search(w, opp ^ flips, own ^ flips ^ BIT(pos),
+                                                -beta, -alpha, false);
+                if(score > best){
+                    best = score;
+                    if(best > alpha){
+                        alpha = best;
+                        if(alpha >= beta){
+                            return best;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    int hashMove = -1;
+    SolveBounds bounds;
+    if(empties >= HASH_EMPTIES && probe(own, opp, &bounds)){
+        if(bounds.lower >= beta){
+            return bounds.lower;
+        }
+        if(bounds.upper <= alpha || bounds.lower == bounds.upper){
+            return bounds.upper;
+        }
+        alpha = max(alpha, bounds.lower);
+        beta = min(beta, bounds.upper);
+        hashMove = bounds.move;
+    }
+
+    int order[MAX_MOVES];
+    int count = orderMoves(own, opp, moves, hashMove, order);
+    int bestMove;
+    int best = searchMoves(w, own, opp, order, count, alpha, beta, &bestMove);
+
+    if(empties >= HASH_EMPTIES && !w->isStopped){
+        store(own, opp, empties, alpha, beta, best, bestMove);
+    }
+    return best;
+}
+
+/**
+ * Searches the moves of a position in order with PVS: the first with the
+ * full window and the rest with null windows, re-searched when they land
+ * inside it. Once the first move is searched, a deep enough position with an
+ * idle thread around is split, and its other moves are shared.
+ * @param  w        Thread doing the search
+ * @param  order    Bit positions of the moves, best first
+ * @param  count    Number of moves
+ * @param  alpha    Lowest score still of interest
+ * @param  beta     Score at which the opponent will avoid this position
+ * @param  bestMove Set to the bit position of the best move
+ * @return          Fail-soft score of the position
+ */
+int EndgameSolver::searchMoves(Worker* w, unsigned long long own,
+            unsigned long long opp, const int* order, int count, int alpha,
+            int beta, int* bestMove){
+    int best = -SOLVE_WINDOW;
+    *bestMove = order[0];
+    bool isSplittable = numThreads > 1
+                    && __builtin_popcountll(~(own | opp)) >= SPLIT_EMPTIES;
+    for(int i = 0; i < count; i++){
+        if(i > 0 && isSplittable && numIdle.load(memory_order_relaxed) > 0){
+            return split(w, own, opp, order + i, count - i, alpha, beta,
+                                                        best, bestMove);
+        }
+        int pos = order[i];
+        unsigned long long flips = Board::findFlips(pos, own, opp);
+        unsigned long long newOwn = opp ^ flips;
+        unsigned long long newOpp = own ^ flips ^ BIT(pos);
+        int score;
+        if(i == 0){
+            score = -search(w, newOwn, newOpp, -beta, -alpha, false);
+        }
+        else{
+            score = -search(w, newOwn, newOpp, -alpha - 1, -alpha, false);
+            if(alpha < score && score < beta){
+                score = -search(w, newOwn, newOpp, -beta, -score, false);
+            }
+        }
+        if(w->isStopped){
+            break;
+        }
+        if(score > best){
+            best = score;
+            *bestMove = pos;
+            if(best > alpha){
+                alpha = best;
+                if(alpha >= beta){
+                    break;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Shares the remaining moves of a position with idle threads and searches
+ * them alongside, then waits for the helpers to finish theirs
+ * @param  w        Thread that owns the position
+ * @param  order    Bit positions of the moves left, best first
+ * @param  count    Number of moves left
+ * @param  alpha    Lowest score still of interest
+ * @param  beta     Score at which the opponent will avoid this position
+ * @param  best     Best score of the moves searched so far
+ * @param  bestMove Best move so far, set to the best move overall
+ * @return          Fail-soft score of the position
+ */
+int EndgameSolver::split(Worker* w, unsigned long long own,
+            unsigned long long opp, const int* order, int count, int alpha,
+            int beta, int best, int* bestMove){
+    SplitPoint sp;
+    sp.parent = w->splitPoint;
+    sp.own = own;
+    sp.opp = opp;
+    sp.order = order;
+    sp.count = count;
+    sp.beta = beta;
+    sp.nextMove = 0;
+    sp.numHelpers = 0;
+    sp.alpha = alpha;
+    sp.isCutoff = false;
+    sp.best = best;
+    sp.bestMove = *bestMove;
+
+    {
+        lock_guard<mutex> lock(splitLock);
+        splitPoints.push_back(&sp);
+    }
+    splitReady.notify_all();
+
+    searchSplit(w, &sp);
+
+    {
+        lock_guard<mutex> lock(splitLock);
+        splitPoints.erase(find(splitPoints.begin(), splitPoints.end(), &sp));
+    }
+    while(sp.numHelpers.load() > 0){
+        this_thread::yield();
+    }
+
+    *bestMove = sp.bestMove;
+    return sp.best;
+}
+
+/**
+ * Takes moves of a split point one at a time and searches them, until none
+ * are left or the split point cuts off
+ * @param w  Thread doing the search
+ * @param sp Split point to search the moves of
+ */
+void EndgameSolver::searchSplit(Worker* w, SplitPoint* sp){
+    SplitPoint* outer = w->splitPoint;
+    w->splitPoint = sp;
+    while(!w->isStopped){
+        int i = sp->nextMove.fetch_add(1);
+        if(i >= sp->count){
+            break;
+        }
+        int pos = sp->order[i];
+        unsigned long long flips = Board::findFlips(pos, sp->own, sp->opp);
+        unsigned long long newOwn = sp->opp ^ flips;
+        unsigned long long newOpp = sp->own ^ flips ^ BIT(pos);
+        int alpha = sp->alpha.load();
+        int score = -search(w, newOwn, newOpp, -alpha - 1, -alpha, false);
+        if(!w->isStopped && alpha < score && score < sp->beta){
+            score = -search(w, newOwn, newOpp, -sp->beta, -score, false);
+        }
+        if(w->isStopped){
+            break;
+        }
+
+        lock_guard<mutex> lock(sp->lock);
+        if(score > sp->best){
+            sp->best = score;
+            sp->bestMove = pos;
+            if(score > sp->alpha.load()){
+                sp->alpha.store(score);
+                if(score >= sp->beta){
+                    sp->isCutoff.store(true);
+                }
+            }
+        }
+    }
+    // Only a cutoff of this split point is over once it is left
+    w->splitPoint = outer;
+    w->isStopped = isAborted.load() || isCutoff(outer);
+}
+
+/**
+ * Runs on each helper thread during a solve: waits for a split point with
+ * moves left, helps search them, and repeats until the solve is done
+ */
+void EndgameSolver::help(){
+    Worker w = {0, nullptr, false};
+    unique_lock<mutex> lock(splitLock);
+    while(true){
+        SplitPoint* sp = nullptr;
+        for(int i = 0; i < (int)splitPoints.size(); i++){
+            if(splitPoints[i]->nextMove.load() < splitPoints[i]->count
+                                    && !isCutoff(splitPoints[i])){
+                sp = splitPoints[i];
+                break;
+            }
+        }
+        if(!sp){
+            if(isDone){
+                break;
+            }
+            numIdle++;
+            splitReady.wait(lock);
+            numIdle--;
+            continue;
+        }
+
+        // The owner waits for this count to drop, so it is the last use of sp
+        sp->numHelpers++;
+        lock.unlock();
+        w.isStopped = isAborted.load();
+        searchSplit(&w, sp);
+        sp->numHelpers--;
+        lock.lock();
+    }
+    nodeCount += w.nodeCount;
+}
+
+/**
+ * Solves a position from the root, on all the solver's threads
+ * @param  board    Position to solve
+ * @param  side     Side to move
+ * @param  isExact  True to find the exact final disc difference, false to only
+ *                  find whether the side to move wins, draws or loses
+ * @param  bestMove Set to the best move found
+ * @return          Final disc difference for the side to move with best play.
+ *                  In win/draw/loss mode only the sign is meaningful.
+ */
+int EndgameSolver::solve(Board* board, bool side, bool isExact, Move* bestMove){
+    nodeCount = 0;
+    isAborted = false;
+    isDone = false;
+    startTime = chrono::steady_clock::now();
+
+    vector<thread> helpers;
+    for(int i = 1; i < numThreads; i++){
+        helpers.push_back(thread(&EndgameSolver::help, this));
+    }
+
+    Worker w = {0, nullptr, false};
+    unsigned long long own = board->getPieces(side);
+    unsigned long long opp = board->getPieces(!side);
+    int alpha = isExact ? -SOLVE_WINDOW : -1;
+    int beta = isExact ? SOLVE_WINDOW : 1;
+
+    int score;
+    unsigned long long moves = Board::findMoves(own, opp);
+    if(!moves){
+        *bestMove = NULL_MOVE(side);
+        score = -search(&w, opp, own, -beta, -alpha, true);
+    }
+    else{
+        SolveBounds bounds;
+        int order[MAX_MOVES];
+        int count = orderMoves(own, opp, moves,
+                    probe(own, opp, &bounds) ? bounds.move : -1, order);
+        int bestPos;
+        score = searchMoves(&w, own, opp, order, count, alpha, beta, &bestPos);
+        *bestMove = Move(7 - (bestPos % 8), 7 - (bestPos / 8), side);
+    }
+
+    {
+        lock_guard<mutex> lock(splitLock);
+        isDone = true;
+    }
+    splitReady.notify_all();
+    for(int i = 0; i < (int)helpers.size(); i++){
+        helpers[i].join();
+    }
+    nodeCount += w.nodeCount;
+    return score;
+}
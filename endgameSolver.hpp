@@ -0,0 +1,139 @@
+#ifndef __ENDGAMESOLVER_H__
+#define __ENDGAMESOLVER_H__
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include "common.hpp"
+#include "board.hpp"
+using namespace std;
+
+// Final disc differences lie in [-64, 64]
+#define SOLVE_WINDOW 65
+
+// Positions with at most this many empties are ordered by quadrant parity
+// only; above it moves are ordered fastest-first
+#define PARITY_EMPTIES 5
+// Positions with fewer empties than this skip the hash table
+#define HASH_EMPTIES 7
+#define NUM_SOLVE_TABLE_ENTRIES (1 << 21)
+// Positions with at least this many empties share their moves after the
+// first with idle threads
+#define SPLIT_EMPTIES 12
+
+#define SOLVE_TIME_CHECK_INTERVAL 4096
+
+/**
+ * Solves endgame positions exactly. The search works on the two bitboards
+ * directly, so nothing is allocated or copied per node. Scores are final disc
+ * differences from the side to move's view, with empty squares going to the
+ * winner.
+ *
+ * With more than one thread the search splits the Young Brothers Wait way:
+ * once the first move of a deep enough node has been searched, threads that
+ * are idle join in on the rest of its moves. All threads share the hash
+ * table, which is read and written without locks like the transposition
+ * table.
+ */
+class EndgameSolver {
+
+private:
+    // Packs the bounds, the empties, the best move and the upper half of the
+    // position's key, so a slot torn by two threads fails its check
+    typedef struct {
+        atomic<unsigned long long> own;
+        atomic<unsigned long long> opp;
+        atomic<unsigned long long> data;
+    } SolveEntry;
+
+    typedef struct {
+        int lower;
+        int upper;
+        int empties;
+        int move;
+    } SolveBounds;
+
+    // A node whose remaining moves are shared between threads. Lives on the
+    // stack of the thread that split it, which waits for every helper to
+    // leave before returning.
+    typedef struct SplitPoint {
+        SplitPoint* parent;
+        unsigned long long own;
+        unsigned long long opp;
+        const int* order;
+        int count;
+        int beta;
+        atomic<int> nextMove;
+        atomic<int> numHelpers;
+        atomic<int> alpha;
+        atomic<bool> isCutoff;
+        // Guards best and bestMove
+        mutex lock;
+        int best;
+        int bestMove;
+    } SplitPoint;
+
+    // What each thread keeps to itself during a solve
+    typedef struct {
+        long long nodeCount;
+        // Innermost split point the thread is searching a move of
+        SplitPoint* splitPoint;
+        // Set once the solve is aborted or a split point above has cut off
+        bool isStopped;
+    } Worker;
+
+    // Pairs of entries: the first keeps the one with most empties, the
+    // second always takes the latest store
+    SolveEntry* table;
+
+    int numThreads;
+    atomic<long long> nodeCount;
+    chrono::steady_clock::time_point startTime;
+    int hardTimeLimit;
+    atomic<bool> isAborted;
+
+    // Split points with moves left to search, and idle threads waiting on them
+    mutex splitLock;
+    condition_variable splitReady;
+    vector<SplitPoint*> splitPoints;
+    atomic<int> numIdle;
+    bool isDone;
+
+    int search(Worker* w, unsigned long long own, unsigned long long opp,
+                        int alpha, int beta, bool passed);
+    int searchLast(Worker* w, unsigned long long own, unsigned long long opp,
+                        unsigned long long empty);
+    int searchMoves(Worker* w, unsigned long long own, unsigned long long opp,
+                        const int* order, int count, int alpha, int beta,
+                        int* bestMove);
+    int split(Worker* w, unsigned long long own, unsigned long long opp,
+                        const int* order, int count, int alpha, int beta,
+                        int best, int* bestMove);
+    void searchSplit(Worker* w, SplitPoint* sp);
+    void help();
+    int orderMoves(unsigned long long own, unsigned long long opp,
+                        unsigned long long moves, int hashMove, int* order);
+    bool probe(unsigned long long own, unsigned long long opp,
+                        SolveBounds* bounds);
+    void store(unsigned long long own, unsigned long long opp, int empties,
+                        int alpha, int beta, int score, int move);
+    bool isStopped(Worker* w);
+    static bool isCutoff(SplitPoint* sp);
+
+public:
+    static int finalScore(unsigned long long own, unsigned long long opp);
+
+    EndgameSolver(int numThreads = 1);
+    ~EndgameSolver();
+    void setTimeLimit(int hardMs);
+    int solve(Board* board, bool side, bool isExact, Move* bestMove);
+    bool wasAborted();
+    long long getNodeCount();
+};
+
+#endif
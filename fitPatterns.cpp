@@ -0,0 +1,250 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+#include "common.hpp"
+#include "board.hpp"
+#include "boardNode.hpp"
+#include "endgameSolver.hpp"
+#include "gameRecord.hpp"
+#include "linearHeuristic.hpp"
+#include "patternHeuristic.hpp"
+
+#define NUM_GAMES 4000
+#define SEED 2018
+
+#define OPENING_MOVES 12
+#define PLAY_DEPTH 2
+// Percent of searched moves that are played at random instead, so the games
+// cover positions the search alone would avoid
+#define RANDOM_MOVE_RATE 10
+#define SOLVE_EMPTIES 14
+
+#define NUM_EPOCHS 30
+#define LEARN_RATE 0.06
+// Weights of rarely seen codes are pulled towards zero by this many samples
+#define REGULARIZATION 4.0
+// Every this many positions is held out to measure the fit
+#define VALIDATION_EVERY 10
+
+#define PLAY_WEIGHTS "weights/handmade.weights"
+#define OUTPUT_WEIGHTS "weights/pattern.weights"
+
+typedef struct {
+    unsigned short codes[NUM_PATTERNS];
+    unsigned char stage;
+    signed char score;
+    signed char mobility;
+} Sample;
+
+/**
+ * Records the pattern codes of a board, and of its mirror image so both
+ * orientations of every pattern are seen
+ * @param board Board to record
+ * @param score Final disc difference for black with best play from here on
+ */
+static void addSamples(vector<Sample>& samples, Board& board, int score){
+    board.enablePatterns();
+    Board mirror;
+    mirror.enablePatterns();
+    char data[64];
+    for(int i = 0; i < 64; i++){
+        unsigned long long square = 0x1ULL << ((i % 8) + 8 * (7 - i / 8));
+        data[i] = (board.getPieces(BLACK) & square) ? 'b' :
+                  (board.getPieces(WHITE) & square) ? 'w' : '-';
+    }
+    mirror.setBoard(data);
+
+    int empties = 64 - board.count(BLACK) - board.count(WHITE);
+    Sample s;
+    s.stage = min(empties, NUM_PATTERN_STAGES * PATTERN_STAGE_EMPTIES - 1)
+                                                / PATTERN_STAGE_EMPTIES;
+    s.score = score;
+    s.mobility = board.countMoves(BLACK) - board.countMoves(WHITE);
+    for(int i = 0; i < NUM_PATTERNS; i++){
+        s.codes[i] = board.getPattern(i);
+    }
+    samples.push_back(s);
+    for(int i = 0; i < NUM_PATTERNS; i++){
+        s.codes[i] = mirror.getPattern(i);
+    }
+    samples.push_back(s);
+}
+
+/**
+ * Plays one game: random opening moves, then a shallow search with some
+ * random moves, then perfect play from SOLVE_EMPTIES empties on. Every
+ * position is labelled with the exact result of the game from where the
+ * solver took over, which perfect play keeps.
+ */
+static void playGame(vector<Sample>& samples, mt19937& generator,
+                        LinearHeuristic* heuristic, EndgameSolver* solver){
+    Board board;
+    bool side = BLACK;
+    vector<Board> history;
+    int empties = 60;
+
+    while(!board.isDone() && empties > SOLVE_EMPTIES){
+        MoveList moves = board.possibleMoves(side);
+        Move move = moves[0];
+        bool isRandom = empties > 60 - OPENING_MOVES
+                        || (int)(generator() % 100) < RANDOM_MOVE_RATE;
+        if(isRandom){
+            move = moves[generator() % moves.size()];
+        }
+        else if(moves.size() > 1){
+            BoardNode root(&board, side);
+            move = root.getBestChoice(PLAY_DEPTH, heuristic, nullptr);
+        }
+        board.doMove(move);
+        side = !side;
+        empties = 64 - board.count(BLACK) - board.count(WHITE);
+        history.push_back(board);
+    }
+
+    int score;
+    if(board.isDone()){
+        score = EndgameSolver::finalScore(board.getPieces(BLACK), board.getPieces(WHITE));
+    }
+    else{
+        Move move = NULL_MOVE(side);
+        score = solver->solve(&board, side, true, &move);
+        if(side == WHITE){
+            score = -score;
+        }
+        while(!board.isDone()){
+            solver->solve(&board, side, true, &move);
+            board.doMove(move);
+            side = !side;
+            history.push_back(board);
+        }
+    }
+
+    for(int i = 0; i < (int)history.size(); i++){
+        if(!history[i].isDone()){
+            addSamples(samples, history[i], score);
+        }
+    }
+}
+
+/**
+ * Labels every position of the stored games with the game's score. Games that
+ * stop being legal are used up to the bad move.
+ * @param  filename Game record file, such as one made by importwthor
+ * @return          False if the file could not be read
+ */
+static bool readGames(vector<Sample>& samples, const char* filename){
+    GameRecordReader reader;
+    if(!reader.open(filename)){
+        return false;
+    }
+    GameRecord record;
+    int numGames = 0;
+    while(reader.next(&record)){
+        vector<Board> boards;
+        vector<bool> sides;
+        GameRecordReader::replay(&record, boards, sides);
+        for(int i = 0; i < (int)boards.size(); i++){
+            addSamples(samples, boards[i], record.score);
+        }
+        if(++numGames % 10000 == 0){
+            cerr << "\rGame " << numGames;
+        }
+    }
+    return true;
+}
+
+/**
+ * Predicts the final disc difference for black of a sample
+ */
+static double predict(const Sample& s, const vector<double>& weights,
+                                                const int* offsets){
+    const double* stageWeights = &weights[s.stage * PATTERN_STAGE_SIZE];
+    double sum = stageWeights[MOBILITY_WEIGHT] * s.mobility;
+    for(int i = 0; i < NUM_PATTERNS; i++){
+        sum += stageWeights[offsets[Board::getPatternType(i)] + s.codes[i]];
+    }
+    return sum;
+}
+
+// Fits the PatternHeuristic weight tables to the results of self-play games,
+// or of the games in a record file if one is given. Each epoch moves every
+// weight towards the mean error of the samples it is part of, which converges
+// quickly for sparse tables.
+// Usage: fitpatterns [games]
+int main(int argc, char *argv[]) {
+    vector<Sample> samples;
+    if(argc > 1){
+        if(!readGames(samples, argv[1])){
+            return 1;
+        }
+    }
+    else{
+        mt19937 generator(SEED);
+        LinearHeuristic heuristic(PLAY_WEIGHTS);
+        EndgameSolver solver;
+        for(int game = 0; game < NUM_GAMES; game++){
+            if(game % 100 == 0){
+                cerr << "\rGame " << game << "/" << NUM_GAMES;
+            }
+            playGame(samples, generator, &heuristic, &solver);
+        }
+    }
+    cerr << "\rCollected " << samples.size() << " positions" << endl;
+
+    int offsets[NUM_PATTERN_TYPES];
+    offsets[0] = 0;
+    for(int type = 1; type < NUM_PATTERN_TYPES; type++){
+        offsets[type] = offsets[type - 1] + (int)pow(3, Board::getPatternSize(type - 1));
+    }
+
+    vector<double> weights(NUM_PATTERN_WEIGHTS, 0.0);
+    vector<double> errorSums(NUM_PATTERN_WEIGHTS);
+    vector<int> counts(NUM_PATTERN_WEIGHTS);
+    for(int epoch = 0; epoch < NUM_EPOCHS; epoch++){
+        fill(errorSums.begin(), errorSums.end(), 0.0);
+        fill(counts.begin(), counts.end(), 0);
+        double mobilityErrors[NUM_PATTERN_STAGES] = {0};
+        double mobilitySquares[NUM_PATTERN_STAGES] = {0};
+        double trainError = 0, testError = 0;
+        int numTrain = 0, numTest = 0;
+
+        for(int i = 0; i < (int)samples.size(); i++){
+            double error = samples[i].score - predict(samples[i], weights, offsets);
+            // Both mirror images of a position stay on the same side
+            if((i / 2) % VALIDATION_EVERY == 0){
+                testError += error * error;
+                numTest++;
+                continue;
+            }
+            trainError += error * error;
+            numTrain++;
+            int base = samples[i].stage * PATTERN_STAGE_SIZE;
+            mobilityErrors[samples[i].stage] += error * samples[i].mobility;
+            mobilitySquares[samples[i].stage] += samples[i].mobility * samples[i].mobility;
+            for(int j = 0; j < NUM_PATTERNS; j++){
+                int w = base + offsets[Board::getPatternType(j)] + samples[i].codes[j];
+                errorSums[w] += error;
+                counts[w]++;
+            }
+        }
+
+        for(int w = 0; w < NUM_PATTERN_WEIGHTS; w++){
+            weights[w] += LEARN_RATE * errorSums[w] / (counts[w] + REGULARIZATION);
+        }
+        for(int stage = 0; stage < NUM_PATTERN_STAGES; stage++){
+            weights[stage * PATTERN_STAGE_SIZE + MOBILITY_WEIGHT] += LEARN_RATE *
+                        mobilityErrors[stage] / (mobilitySquares[stage] + REGULARIZATION);
+        }
+
+        cerr << "Epoch " << epoch + 1 << "/" << NUM_EPOCHS << ": train rms "
+             << sqrt(trainError / numTrain) << ", test rms "
+             << sqrt(testError / numTest) << endl;
+    }
+
+    vector<float> fitted(weights.begin(), weights.end());
+    PatternHeuristic::writeWeights(OUTPUT_WEIGHTS, &fitted[0]);
+    cerr << "Saved " << OUTPUT_WEIGHTS << endl;
+    return 0;
+}
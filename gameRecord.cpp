@@ -0,0 +1,208 @@
+#include "gameRecord.hpp"
+
+GameRecordWriter::GameRecordWriter(){
+}
+
+GameRecordWriter::~GameRecordWriter(){
+    close();
+}
+
+/**
+ * Opens a record file for appending, starting it if it is new
+ * @param  filename File to append to
+ * @return          False if the file could not be opened or is not a record
+ *                  file
+ */
+bool GameRecordWriter::open(const char* filename){
+    close();
+    ifstream existing(filename, ios::binary | ios::ate);
+    bool isNew = !existing.is_open() || existing.tellg() == 0;
+    if(!isNew){
+        char magic[GAME_MAGIC_SIZE];
+        existing.seekg(0);
+        existing.read(magic, GAME_MAGIC_SIZE);
+        if(!existing || memcmp(magic, GAME_MAGIC, GAME_MAGIC_SIZE) != 0){
+            cerr << "Record file " << filename << " is malformed" << endl;
+            return false;
+        }
+    }
+    existing.close();
+
+    file.open(filename, ios::binary | ios::app);
+    if(!file.is_open()){
+        cerr << "Error opening file: " << filename << endl;
+        return false;
+    }
+    if(isNew){
+        file.write(GAME_MAGIC, GAME_MAGIC_SIZE);
+    }
+    return file.good();
+}
+
+void GameRecordWriter::close(){
+    if(file.is_open()){
+        file.close();
+    }
+}
+
+/**
+ * Appends a game to the file
+ * @param  record Game to append
+ * @return        False if the write failed
+ */
+bool GameRecordWriter::write(GameRecord* record){
+    unsigned char header[RECORD_HEADER_SIZE];
+    header[0] = record->numMoves;
+    header[1] = record->hasSnapshots ? RECORD_HAS_SNAPSHOTS : 0;
+    header[2] = (unsigned char)(signed char)record->score;
+    header[3] = 0;
+    file.write((const char*)header, RECORD_HEADER_SIZE);
+    file.write((const char*)record->moves, record->numMoves);
+    if(record->hasSnapshots){
+        for(int i = 0; i < record->numMoves; i++){
+            file.write((const char*)record->snapshots[i].pieces, 16);
+            file.write((const char*)&record->snapshots[i].score, 4);
+        }
+    }
+    return file.good();
+}
+
+/**
+ * Constructs a reader with no file open, which has no games
+ */
+GameRecordReader::GameRecordReader(){
+    mapping = nullptr;
+    mappingSize = 0;
+    offset = 0;
+}
+
+GameRecordReader::~GameRecordReader(){
+    close();
+}
+
+/**
+ * Maps a record file into memory for reading from the first game
+ * @param  filename File to read
+ * @return          False if the file is missing or not a record file
+ */
+bool GameRecordReader::open(const char* filename){
+    close();
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0){
+        cerr << "Error opening file: " << filename << endl;
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) < 0 || info.st_size < GAME_MAGIC_SIZE){
+        ::close(fd);
+        cerr << "Record file " << filename << " is malformed" << endl;
+        return false;
+    }
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED){
+        return false;
+    }
+    if(memcmp(data, GAME_MAGIC, GAME_MAGIC_SIZE) != 0){
+        cerr << "Record file " << filename << " is malformed" << endl;
+        munmap(data, info.st_size);
+        return false;
+    }
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    mapping = data;
+    mappingSize = info.st_size;
+    offset = GAME_MAGIC_SIZE;
+    return true;
+}
+
+/**
+ * Unmaps the file, if one is open
+ */
+void GameRecordReader::close(){
+    if(mapping){
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    offset = 0;
+}
+
+/**
+ * Goes back to the first game
+ */
+void GameRecordReader::rewind(){
+    offset = mapping ? GAME_MAGIC_SIZE : 0;
+}
+
+/**
+ * Reads the next game
+ * @param  record Set to the game
+ * @return        False at the end of the file, or if the rest of the file
+ *                is cut short or malformed
+ */
+bool GameRecordReader::next(GameRecord* record){
+    const unsigned char* data = (const unsigned char*)mapping;
+    if(!mapping || offset + RECORD_HEADER_SIZE > mappingSize){
+        return false;
+    }
+    const unsigned char* header = data + offset;
+    int numMoves = header[0];
+    bool hasSnapshots = header[1] & RECORD_HAS_SNAPSHOTS;
+    size_t length = RECORD_HEADER_SIZE + numMoves
+                    + (hasSnapshots ? numMoves * SNAPSHOT_SIZE : 0);
+    if(numMoves > MAX_GAME_MOVES || offset + length > mappingSize){
+        offset = mappingSize;
+        return false;
+    }
+
+    record->numMoves = numMoves;
+    record->score = (signed char)header[2];
+    record->hasSnapshots = hasSnapshots;
+    memcpy(record->moves, header + RECORD_HEADER_SIZE, numMoves);
+    if(hasSnapshots){
+        const unsigned char* snapshot = header + RECORD_HEADER_SIZE + numMoves;
+        for(int i = 0; i < numMoves; i++){
+            memcpy(record->snapshots[i].pieces, snapshot, 16);
+            memcpy(&record->snapshots[i].score, snapshot + 16, 4);
+            snapshot += SNAPSHOT_SIZE;
+        }
+    }
+    offset += length;
+    return true;
+}
+
+/**
+ * Plays a game through from the starting position, passing whenever the side
+ * to move has no moves
+ * @param  record Game to play through
+ * @param  boards Filled with the position before each move
+ * @param  sides  Filled with the side making each move
+ * @return        False if a move is not legal, in which case the positions
+ *                stop before it
+ */
+bool GameRecordReader::replay(GameRecord* record, vector<Board>& boards,
+                                                    vector<bool>& sides){
+    Board board;
+    bool side = BLACK;
+    for(int i = 0; i < record->numMoves; i++){
+        // A pass is a null move, which also keeps the board's parity right
+        if(!board.hasMoves(side)){
+            board.doMove(NULL_MOVE(side));
+            side = !side;
+        }
+        int pos = record->moves[i];
+        if(pos >= 64){
+            return false;
+        }
+        Move move(7 - pos % 8, 7 - pos / 8, side);
+        if(!board.checkMove(move)){
+            return false;
+        }
+        boards.push_back(board);
+        sides.push_back(side);
+        board.doMove(move);
+        side = !side;
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef __GAMERECORD_H__
+#define __GAMERECORD_H__
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "common.hpp"
+#include "board.hpp"
+using namespace std;
+
+#define GAME_MAGIC "OTHGAME1"
+#define GAME_MAGIC_SIZE 8
+// Passes are not stored, so a game has at most one move per empty square
+#define MAX_GAME_MOVES 60
+#define RECORD_HEADER_SIZE 4
+#define SNAPSHOT_SIZE 20
+#define RECORD_HAS_SNAPSHOTS 0x01
+
+/**
+ * Leaf of the principal variation the search found when a move was chosen,
+ * with its score for the side that moved
+ */
+typedef struct {
+    unsigned long long pieces[2];
+    float score;
+} PositionSnapshot;
+
+/**
+ * One game: its moves as bit positions, with passes left out since they are
+ * forced, and the final disc difference for black. Games played by our own
+ * search can also keep a snapshot for each move.
+ */
+typedef struct {
+    int numMoves;
+    unsigned char moves[MAX_GAME_MOVES];
+    int score;
+    bool hasSnapshots;
+    PositionSnapshot snapshots[MAX_GAME_MOVES];
+} GameRecord;
+
+/**
+ * Appends games to a record file. The file is an 8 byte magic string followed
+ * by the games back to back. Each game is a 4 byte header (number of moves,
+ * flags, score for black, unused), a byte per move, then, if the flags say
+ * so, a 20 byte snapshot per move: both bitboards and the score as a float.
+ */
+class GameRecordWriter {
+
+private:
+    ofstream file;
+
+public:
+    GameRecordWriter();
+    ~GameRecordWriter();
+    bool open(const char* filename);
+    void close();
+    bool write(GameRecord* record);
+};
+
+/**
+ * Streams the games of a record file from a read-only memory mapping, so
+ * going over stored games costs no more than reading the file
+ */
+class GameRecordReader {
+
+private:
+    void* mapping;
+    size_t mappingSize;
+    size_t offset;
+
+public:
+    static bool replay(GameRecord* record, vector<Board>& boards,
+                                            vector<bool>& sides);
+
+    GameRecordReader();
+    ~GameRecordReader();
+    bool open(const char* filename);
+    void close();
+    void rewind();
+    bool next(GameRecord* record);
+};
+
+#endif
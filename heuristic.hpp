@@ -3,18 +3,27 @@
 
 #include "common.hpp"
 #include "board.hpp"
-#include <Eigen/Dense>
 #include <string>
 using namespace std;
-using namespace Eigen;
 
+/**
+ * Scores boards for the search. The search is templated on the concrete
+ * heuristic, so getScore is called directly and inlined there; the virtual
+ * interface is only used by training code. Each concrete heuristic also has
+ * getChildScores, which scores every child of a position in one call for the
+ * search's frontier nodes. Weights and gradients are plain
+ * arrays of getNumWeights() values. Boards are readied with prepareBoard
+ * before a search scores them.
+ */
 class Heuristic {
 public:
     Heuristic() {}
     virtual ~Heuristic() {}
     virtual double getScore(Board* board, bool side) = 0;
-    virtual VectorXd getGrad(Board* board, bool side) = 0;
-    virtual void updateWeights(VectorXd& deltaWeights) = 0;
+    virtual void prepareBoard(Board* board) {}
+    virtual int getNumWeights() = 0;
+    virtual void getGrad(Board* board, bool side, double* grad) = 0;
+    virtual void updateWeights(const double* deltaWeights) = 0;
     virtual void saveWeights(const char* filename) = 0;
 };
 
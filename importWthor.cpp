@@ -0,0 +1,100 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include "common.hpp"
+#include "board.hpp"
+#include "gameRecord.hpp"
+
+#define WTHOR_HEADER_SIZE 16
+#define WTHOR_GAME_SIZE 68
+// Offsets within a game: the theoretical score is black's discs with perfect
+// play from the depth given in the file header, then the 60 moves
+#define WTHOR_THEORETICAL_SCORE 7
+#define WTHOR_MOVES 8
+
+/**
+ * Converts a WTHOR game to a record. Moves are stored as 10 * row + column,
+ * counting from 1, with 0 for no move; passes are not stored.
+ * @param  game   The 68 bytes of the game
+ * @param  record Set to the game
+ * @return        False if the game has an illegal move
+ */
+static bool convertGame(const unsigned char* game, GameRecord* record){
+    record->numMoves = 0;
+    record->hasSnapshots = false;
+    record->score = 2 * game[WTHOR_THEORETICAL_SCORE] - 64;
+    for(int i = 0; i < MAX_GAME_MOVES; i++){
+        int code = game[WTHOR_MOVES + i];
+        if(code == 0){
+            break;
+        }
+        int x = code % 10 - 1;
+        int y = code / 10 - 1;
+        if(x < 0 || x > 7 || y < 0 || y > 7){
+            return false;
+        }
+        record->moves[record->numMoves++] = (7 - x) + 8 * (7 - y);
+    }
+
+    vector<Board> boards;
+    vector<bool> sides;
+    return GameRecordReader::replay(record, boards, sides);
+}
+
+// Appends the games of WTHOR database files to a game record file, for the
+// training tools to read. Games with illegal moves are skipped.
+// Usage: importwthor output.games input.wtb [input.wtb ...]
+int main(int argc, char *argv[]) {
+    if(argc < 3){
+        cerr << "usage: " << argv[0] << " output.games input.wtb [input.wtb ...]"
+             << endl;
+        return 1;
+    }
+
+    GameRecordWriter writer;
+    if(!writer.open(argv[1])){
+        return 1;
+    }
+
+    int numImported = 0;
+    int numSkipped = 0;
+    for(int file = 2; file < argc; file++){
+        ifstream ifile(argv[file], ios::binary);
+        unsigned char header[WTHOR_HEADER_SIZE];
+        if(!ifile.read((char*)header, WTHOR_HEADER_SIZE)){
+            cerr << "Error opening file: " << argv[file] << endl;
+            return 1;
+        }
+        unsigned int numGames = header[4] | (header[5] << 8) | (header[6] << 16)
+                                | ((unsigned int)header[7] << 24);
+        // Byte 12 is the board size, 0 or 8 for standard games
+        if(header[12] != 0 && header[12] != 8){
+            cerr << argv[file] << " is not an 8x8 game file" << endl;
+            return 1;
+        }
+
+        unsigned char game[WTHOR_GAME_SIZE];
+        GameRecord record;
+        for(unsigned int i = 0; i < numGames; i++){
+            if(!ifile.read((char*)game, WTHOR_GAME_SIZE)){
+                cerr << argv[file] << " ends after " << i << " of " << numGames
+                     << " games" << endl;
+                break;
+            }
+            if(!convertGame(game, &record)){
+                numSkipped++;
+                continue;
+            }
+            if(!writer.write(&record)){
+                cerr << "Error writing file: " << argv[1] << endl;
+                return 1;
+            }
+            numImported++;
+        }
+    }
+
+    writer.close();
+    cerr << "Imported " << numImported << " games, skipped " << numSkipped
+         << endl;
+    return 0;
+}
@@ -1,11 +1,19 @@
 #include <iostream>
 #include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
 #include <Eigen/Dense>
 #include "common.hpp"
 #include "board.hpp"
 #include "linearHeuristic.hpp"
 #include "timeHeuristic.hpp"
 #include "boardNodeLearning.hpp"
+#include "gameRecord.hpp"
+
+using namespace Eigen;
 
 #define LEARN_RATE .02
 #define LEARN_SLOW_RATE .97
@@ -17,113 +25,205 @@
 #define PREGAME_MOVES 6
 #define SEARCH_DEPTH 5
 
+// Each game seeds its own generator from this, its batch and its number, so
+// a run gives the same weights whatever the number of threads
+#define SEED 2018
+
 #define INPUT_WEIGHTS "weights/time.weights"
 #define OUTPUT_WEIGHTS "weights/time.weights"
 
-// Use this file to test your minimax implementation (2-ply depth, with a
-// heuristic of the difference in number of pieces).
-int main(int argc, char *argv[]) {
+/**
+ * Adds a move to a game record, leaving out passes
+ * @param record   Game to add to
+ * @param move     Move that was made
+ * @param snapshot Board to keep for the move
+ * @param score    Score of the snapshot for the side that moved
+ */
+static void addMove(GameRecord* record, Move move, Board* snapshot, float score){
+    if (move.isNull()) {
+        return;
+    }
+    PositionSnapshot* s = &record->snapshots[record->numMoves];
+    s->pieces[BLACK] = snapshot->getPieces(BLACK);
+    s->pieces[WHITE] = snapshot->getPieces(WHITE);
+    s->score = score;
+    record->moves[record->numMoves++] = (7 - move.getX()) + 8 * (7 - move.getY());
+}
 
-    cerr << endl;
+/**
+ * Plays one game of self-play from a few random opening moves and finds its
+ * TD-Leaf(lambda) update
+ * @param heuristic   Heuristic to search and learn with, only read
+ * @param generator   Random numbers for the opening moves
+ * @param weightDelta Set to the sum of the game's updates, before scaling by
+ *                    the learning rate
+ * @param numDeltas   Set to the number of positions that gave an update
+ * @param record      Set to the game, with the principal leaf of each move
+ *                    as its snapshot. Random opening moves have the position
+ *                    after the move.
+ */
+static void playGame(TimeHeuristic* heuristic, mt19937& generator,
+                VectorXd* weightDelta, int* numDeltas, GameRecord* record){
+    *weightDelta = VectorXd::Zero(heuristic->getNumWeights());
+    *numDeltas = 0;
+    record->numMoves = 0;
+    record->hasSnapshots = true;
+
+    // Init Board
+    Board *board = new Board();
+    bool movingSide = BLACK;
+
+    // Randomly play first few moves to get (hopefully) unique boardstate
+    // I estimate there is on the order of 1000 possible states 6 moves in
+    for (int i = 0; i < PREGAME_MOVES; i++) {
+        MoveList moves = board->possibleMoves(movingSide);
+        Move chosenMove = moves[generator() % moves.size()];
+        board->doMove(chosenMove);
+        addMove(record, chosenMove, board, heuristic->getScore(board, movingSide));
+        movingSide = !movingSide;
+    }
 
-    TimeHeuristic* heuristic = new TimeHeuristic(INPUT_WEIGHTS);
-    heuristic->saveWeights(OUTPUT_WEIGHTS);
+    // Setup for game to be played
+    BoardNodeLearning* root = nullptr;
+    vector<Board*> principals[2];
+    principals[BLACK] = vector<Board*>();
+    principals[WHITE] = vector<Board*>();
 
-    for (int batch = 0; batch < NUM_BATCHES; batch++) {
+    // Play Game
+    while (!board->isDone()) {
+        root = new BoardNodeLearning(board, movingSide);
+        Move move = root->getBestChoice(SEARCH_DEPTH, heuristic);
 
-        // Zero delta for new batch
-        VectorXd weightDelta = VectorXd::Zero(NUM_TOTAL_WEIGHTS);
-        int numDeltas = 0;
+        board->doMove(move);
 
-        for (int game = 0; game < BATCH_SIZE; game++) {
+        principals[movingSide].push_back(root->getPrincipalBoard());
+        addMove(record, move, principals[movingSide].back(),
+                heuristic->getScore(principals[movingSide].back(), movingSide));
 
-            cerr << "\rGame " << game+1 << "/" << BATCH_SIZE;
+        delete root;
+        movingSide = !movingSide;
+    }
 
-            // Init Board
-            Board *board = new Board();
-            bool movingSide = BLACK;
+    record->score = board->count(BLACK) - board->count(WHITE);
 
-            // Randomly play first few moves to get (hopefully) unique boardstate
-            // I estimate there is on the order of 1000 possible states 6 moves in
-            for (int i = 0; i < PREGAME_MOVES; i++) {
-                vector<Move> moves = board->possibleMoves(movingSide);
-                Move chosenMove = moves[rand() % moves.size()];
-                board->doMove(chosenMove);
-                movingSide = !movingSide;
-            }
+    // Setup for principal data extraction
+    vector<double> diffs[2];
+    diffs[BLACK] = vector<double>();
+    diffs[WHITE] = vector<double>();
+    vector<VectorXd> derivs[2];
+    derivs[BLACK] = vector<VectorXd>();
+    derivs[WHITE] = vector<VectorXd>();
 
-            // Setup for game to be played
-            BoardNodeLearning* root = nullptr;
-            vector<Board*> principals[2];
-            principals[BLACK] = vector<Board*>();
-            principals[WHITE] = vector<Board*>();
+    // Pull data from principals
+    for (int i = 0; i < (int)principals[BLACK].size() - 1; i++) {
+        Board* principal = principals[BLACK][i];
+        Board* nextPrincipal = principals[BLACK][i+1];
 
-            // Play Game
-            while (!board->isDone()) {
-                root = new BoardNodeLearning(board, movingSide);
-                Move move = root->getBestChoice(SEARCH_DEPTH, heuristic);
+        VectorXd grad(heuristic->getNumWeights());
+        heuristic->getGrad(principal, BLACK, grad.data());
+        derivs[BLACK].push_back(grad);
 
-                board->doMove(move);
+        diffs[BLACK].push_back(heuristic->getScore(nextPrincipal, BLACK)
+                        - heuristic->getScore(principal, BLACK));
+    }
+    for (int i = 0; i < (int)principals[WHITE].size() - 1; i++) {
+        Board* principal = principals[WHITE][i];
+        Board* nextPrincipal = principals[WHITE][i+1];
+
+        VectorXd grad(heuristic->getNumWeights());
+        heuristic->getGrad(principal, WHITE, grad.data());
+        derivs[WHITE].push_back(grad);
 
-                principals[movingSide].push_back(root->getPrincipalBoard());
+        diffs[WHITE].push_back(heuristic->getScore(nextPrincipal, WHITE)
+                        - heuristic->getScore(principal, WHITE));
+    }
 
-                delete root;
-                movingSide = !movingSide;
+    // Calculate delta
+    for (int side = 0; side <= 1; side++) {
+        for (int i = 0; i < (int)derivs[side].size(); i++) {
+            double scalar = 0;
+            for (int j = i; j < (int)diffs[side].size(); j++) {
+                scalar += pow(LAMBDA, j-i) * diffs[side][j];
             }
+            *weightDelta += derivs[side][i] * scalar;
+            (*numDeltas)++;
+        }
+    }
 
-            // Setup for principal data extraction
-            vector<double> diffs[2];
-            diffs[BLACK] = vector<double>();
-            diffs[WHITE] = vector<double>();
-            vector<VectorXd> derivs[2];
-            derivs[BLACK] = vector<VectorXd>();
-            derivs[WHITE] = vector<VectorXd>();
+    // Cleanup
+    for (int i = 0; i < (int)principals[BLACK].size(); i++) {
+        delete principals[BLACK][i];
+    }
+    for (int i = 0; i < (int)principals[WHITE].size(); i++) {
+        delete principals[WHITE][i];
+    }
+    principals[BLACK].clear();
+    principals[WHITE].clear();
+    delete board;
+}
 
-            // Pull data from principals
-            for (int i = 0; i < (int)principals[BLACK].size() - 1; i++) {
-                Board* principal = principals[BLACK][i];
-                Board* nextPrincipal = principals[BLACK][i+1];
+// Tunes the time heuristic by TD-Leaf(lambda) over batches of self-play
+// games. The games of a batch are played on a pool of threads and their
+// updates are summed in game order at the end of the batch. Given a record
+// file, the games are appended to it so they can be trained on again.
+// Usage: learn [threads] [games]
+int main(int argc, char *argv[]) {
 
-                derivs[BLACK].push_back(heuristic->getGrad(principal, BLACK));
+    int numThreads = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+    numThreads = max(numThreads, 1);
+    GameRecordWriter writer;
+    if (argc > 2 && !writer.open(argv[2])) {
+        return 1;
+    }
+    cerr << endl;
 
-                diffs[BLACK].push_back(heuristic->getScore(nextPrincipal, BLACK)
-                                - heuristic->getScore(principal, BLACK));
-            }
-            for (int i = 0; i < (int)principals[WHITE].size() - 1; i++) {
-                Board* principal = principals[WHITE][i];
-                Board* nextPrincipal = principals[WHITE][i+1];
+    // Build the board tables before any worker needs them
+    Board tableInit;
 
-                derivs[WHITE].push_back(heuristic->getGrad(principal, WHITE));
+    TimeHeuristic* heuristic = new TimeHeuristic(INPUT_WEIGHTS);
+    heuristic->saveWeights(OUTPUT_WEIGHTS);
 
-                diffs[WHITE].push_back(heuristic->getScore(nextPrincipal, WHITE)
-                                - heuristic->getScore(principal, WHITE));
-            }
+    for (int batch = 0; batch < NUM_BATCHES; batch++) {
 
-            // Calculate delta
-            for (int side = 0; side <= 1; side++) {
-                for (int i = 0; i < (int)derivs[side].size(); i++) {
-                    double scalar = 0;
-                    for (int j = i; j < (int)diffs[side].size(); j++) {
-                        scalar += pow(LAMBDA, j-i) * diffs[side][j];
-                    }
-                    weightDelta += pow(LEARN_SLOW_RATE, batch) * LEARN_RATE * derivs[side][i] * scalar;
-                    numDeltas ++;
-                }
+        vector<VectorXd> gameDeltas(BATCH_SIZE);
+        vector<int> gameCounts(BATCH_SIZE);
+        vector<GameRecord> records(BATCH_SIZE);
+        atomic<int> nextGame(0);
+        int gamesDone = 0;
+        mutex progressLock;
+
+        auto worker = [&]() {
+            int game;
+            while ((game = nextGame.fetch_add(1)) < BATCH_SIZE) {
+                seed_seq seed{SEED, batch, game};
+                mt19937 generator(seed);
+                playGame(heuristic, generator, &gameDeltas[game], &gameCounts[game],
+                                                        &records[game]);
+
+                lock_guard<mutex> lock(progressLock);
+                gamesDone++;
+                cerr << "\rGame " << gamesDone << "/" << BATCH_SIZE;
             }
+        };
+        vector<thread> threads;
+        for (int i = 1; i < numThreads; i++) {
+            threads.push_back(thread(worker));
+        }
+        worker();
+        for (int i = 0; i < (int)threads.size(); i++) {
+            threads[i].join();
+        }
 
-            // Cleanup
-            for (int i = 0; i < (int)principals[BLACK].size(); i++) {
-                delete principals[BLACK][i];
-            }
-            for (int i = 0; i < (int)principals[WHITE].size(); i++) {
-                delete principals[WHITE][i];
+        VectorXd weightDelta = VectorXd::Zero(heuristic->getNumWeights());
+        int numDeltas = 0;
+        for (int game = 0; game < BATCH_SIZE; game++) {
+            weightDelta += gameDeltas[game];
+            numDeltas += gameCounts[game];
+            if (argc > 2) {
+                writer.write(&records[game]);
             }
-            principals[BLACK].clear();
-            principals[WHITE].clear();
-            delete board;
         }
-
-        weightDelta /= (double)numDeltas;
+        weightDelta *= pow(LEARN_SLOW_RATE, batch) * LEARN_RATE / (double)numDeltas;
 
         cerr << endl;
         cerr << endl;
@@ -131,7 +231,7 @@ int main(int argc, char *argv[]) {
         cerr << weightDelta << endl;
         cerr << endl;
 
-        heuristic->updateWeights(weightDelta);
+        heuristic->updateWeights(weightDelta.data());
         heuristic->saveWeights(OUTPUT_WEIGHTS);
 
     }
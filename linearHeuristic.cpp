@@ -1,7 +1,6 @@
 #include "linearHeuristic.hpp"
 
-LinearHeuristic::LinearHeuristic(const char* filename) :
-            weights(NUM_LIN_WEIGHTS) {
+LinearHeuristic::LinearHeuristic(const char* filename) {
 
     if (strcmp(filename, "weights/random.weights") == 0) {
         for (int i = 0; i < NUM_LIN_WEIGHTS; i++) {
@@ -40,51 +39,34 @@ LinearHeuristic::LinearHeuristic(const char* filename) :
 LinearHeuristic::~LinearHeuristic() {
 }
 
-VectorXd LinearHeuristic::getInputs(Board* board, bool side) {
-    VectorXd inputs(NUM_LIN_WEIGHTS);
-
-    inputs[0] = board->count(side) - board->count(!side);
-    inputs[1] = board->countMoves(side) - board->countMoves(!side);
-    inputs[2] = board->countStable(side) - board->countStable(!side);
-    inputs[3] = board->getFrontierSize(side) - board->getFrontierSize(!side);
-    inputs[4] = (board->getParity() == side) ? 1 : -1;
-
-    return inputs;
+int LinearHeuristic::getNumWeights(){
+    return NUM_LIN_WEIGHTS;
 }
 
-double LinearHeuristic::getScore(Board* board, bool side){
-    if (board->isDone()) {
-        int difference = board->count(side) - board->count(!side);
-        if (difference > 0) {
-            return 1;
-        }
-        else if (difference == 0) {
-            return 0;
-        }
-        else {
-            return -1;
+void LinearHeuristic::getGrad(Board* board, bool side, double* grad){
+    BoardFeatures features;
+    board->getFeatures(&features);
+    if (features.isDone) {
+        for (int i = 0; i < NUM_LIN_WEIGHTS; i++) {
+            grad[i] = 0;
         }
+        return;
     }
 
-    VectorXd inputs = getInputs(board, side);
-
-    return TANH_MAX * tanh(TANH_SLOPE * weights.dot(inputs));
-}
+    double inputs[NUM_LIN_WEIGHTS];
+    getInputs(&features, side, inputs);
+    double score = getScore(board, side);
 
-
-VectorXd LinearHeuristic::getGrad(Board* board, bool side){
-    if (board->isDone()) {
-        return VectorXd::Zero(NUM_LIN_WEIGHTS);
+    double scalar = TANH_MAX * TANH_SLOPE * (1 - pow(tanh(TANH_SLOPE * score), 2));
+    for (int i = 0; i < NUM_LIN_WEIGHTS; i++) {
+        grad[i] = inputs[i] * scalar;
     }
-
-    VectorXd inputs = getInputs(board, side);
-    double score = TANH_MAX * tanh(TANH_SLOPE * weights.dot(inputs));
-
-    return inputs * (TANH_MAX * TANH_SLOPE * (1 - pow(tanh(TANH_SLOPE * score), 2)));
 }
 
-void LinearHeuristic::updateWeights(VectorXd& deltaWeights){
-    weights += deltaWeights;
+void LinearHeuristic::updateWeights(const double* deltaWeights){
+    for (int i = 0; i < NUM_LIN_WEIGHTS; i++) {
+        weights[i] += deltaWeights[i];
+    }
 }
 
 void LinearHeuristic::saveWeights(const char* filename) {
@@ -4,31 +4,88 @@
 #include "common.hpp"
 #include "board.hpp"
 #include "heuristic.hpp"
-#include <Eigen/Dense>
 #include <fstream>
 #include <math.h>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 
 using namespace std;
-using namespace Eigen;
 
 #define NUM_LIN_WEIGHTS 5
 #define TANH_MAX 0.999
 #define TANH_SLOPE 1
 
-class LinearHeuristic : public Heuristic{
+class LinearHeuristic final : public Heuristic{
 private:
-    VectorXd weights;
+    double weights[NUM_LIN_WEIGHTS];
 
-    VectorXd getInputs(Board* board, bool side);
+    inline void getInputs(BoardFeatures* features, bool side, double* inputs);
+    inline double scoreFeatures(BoardFeatures* features, bool side);
 public:
     LinearHeuristic(const char* filename);
     ~LinearHeuristic();
-    double getScore(Board* board, bool side);
-    VectorXd getGrad(Board* board, bool side);
-    void updateWeights(VectorXd& deltaWeights);
+    inline double getScore(Board* board, bool side);
+    inline void getChildScores(Board* board, bool side,
+                unsigned long long moves, float* scores);
+    int getNumWeights();
+    void getGrad(Board* board, bool side, double* grad);
+    void updateWeights(const double* deltaWeights);
     void saveWeights(const char* filename);
 };
 
+inline void LinearHeuristic::getInputs(BoardFeatures* features, bool side, double* inputs) {
+    inputs[0] = features->discs[side] - features->discs[!side];
+    inputs[1] = features->mobility[side] - features->mobility[!side];
+    inputs[2] = features->stable[side] - features->stable[!side];
+    inputs[3] = features->frontier[side] - features->frontier[!side];
+    inputs[4] = (features->parity == side) ? 1 : -1;
+}
+
+inline double LinearHeuristic::scoreFeatures(BoardFeatures* features, bool side){
+    if (features->isDone) {
+        int difference = features->discs[side] - features->discs[!side];
+        if (difference > 0) {
+            return 1;
+        }
+        else if (difference == 0) {
+            return 0;
+        }
+        else {
+            return -1;
+        }
+    }
+
+    double inputs[NUM_LIN_WEIGHTS];
+    getInputs(features, side, inputs);
+
+    double sum = 0;
+    for (int i = 0; i < NUM_LIN_WEIGHTS; i++) {
+        sum += weights[i] * inputs[i];
+    }
+    return TANH_MAX * tanh(TANH_SLOPE * sum);
+}
+
+inline double LinearHeuristic::getScore(Board* board, bool side){
+    BoardFeatures features;
+    board->getFeatures(&features);
+    return scoreFeatures(&features, side);
+}
+
+/**
+ * Scores every position one move away in one pass over their features
+ * @param board  Position to move from
+ * @param side   Side making the moves, whose view the scores are from
+ * @param moves  Grid of bits with the moves to score set
+ * @param scores Set to the score of each move, highest bit first
+ */
+inline void LinearHeuristic::getChildScores(Board* board, bool side,
+                        unsigned long long moves, float* scores){
+    BoardFeatures features[MAX_MOVES];
+    int n = board->getChildFeatures(side, moves, features);
+    for (int i = 0; i < n; i++) {
+        scores[i] = scoreFeatures(&features[i], side);
+    }
+}
+
 #endif
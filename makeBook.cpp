@@ -0,0 +1,139 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <limits>
+#include <cstdlib>
+#include "common.hpp"
+#include "board.hpp"
+#include "boardNode.hpp"
+#include "transTable.hpp"
+#include "probCut.hpp"
+#include "openingBook.hpp"
+#include "linearHeuristic.hpp"
+#include "timeHeuristic.hpp"
+#include "patternHeuristic.hpp"
+
+#define DEFAULT_WEIGHTS "weights/handmade.weights"
+// Plies from the start of the game that the book covers
+#define DEFAULT_BOOK_PLIES 10
+#define DEFAULT_BOOK_DEPTH 10
+// Moves scoring within this much of the best move are followed further, so
+// the book covers every reasonable reply
+#define BOOK_WINDOW 0.02
+#define BOOK_T_TABLE_ENTRIES (1 << 22)
+
+typedef struct {
+    Board board;
+    bool side;
+    int ply;
+} BookPosition;
+
+/**
+ * Builds the book breadth first from the starting position. Every move of a
+ * position is searched to the book depth; the best one is stored, and all
+ * moves within BOOK_WINDOW of it are expanded. Mirror images of a position
+ * are only searched once.
+ */
+template<class H>
+static vector<BookEntry> buildBook(H* heuristic, ProbCut* probCut,
+                                        int numPlies, int depth){
+    vector<BookEntry> entries;
+    unordered_set<unsigned long long> seen;
+    TransTable tTable(BOOK_T_TABLE_ENTRIES);
+    deque<BookPosition> queue;
+    queue.push_back({Board(), BLACK, 0});
+
+    while(!queue.empty()){
+        BookPosition p = queue.front();
+        queue.pop_front();
+        if(!seen.insert(p.board.getCanonicalKey(p.side)).second){
+            continue;
+        }
+        MoveList moves = p.board.possibleMoves(p.side);
+        if(moves[0].isNull()){
+            continue;
+        }
+
+        tTable.newSearch();
+        float scores[MAX_MOVES];
+        int best = 0;
+        for(int i = 0; i < moves.size(); i++){
+            Board child = p.board;
+            child.doMove(moves[i]);
+            BoardNode node(&child, !p.side);
+            node.setProbCut(probCut);
+            scores[i] = -node.searchTreePVS(depth - 1,
+                        -numeric_limits<float>::max(),
+                        numeric_limits<float>::max(), heuristic, &tTable);
+            if(scores[i] > scores[best]){
+                best = i;
+            }
+        }
+        entries.push_back(OpeningBook::makeEntry(&p.board, p.side,
+                                        moves[best], scores[best], depth));
+
+        if(p.ply + 1 < numPlies){
+            for(int i = 0; i < moves.size(); i++){
+                if(scores[i] >= scores[best] - BOOK_WINDOW){
+                    BookPosition child = {p.board, !p.side, p.ply + 1};
+                    child.board.doMove(moves[i]);
+                    queue.push_back(child);
+                }
+            }
+        }
+        if(entries.size() % 10 == 0){
+            cerr << "\r" << entries.size() << " positions, ply " << p.ply
+                 << ", " << queue.size() << " queued";
+        }
+    }
+    cerr << endl;
+    return entries;
+}
+
+// Builds an opening book for a set of weights, searched with the weights'
+// Multi-ProbCut parameters if there are any, and saves it next to them.
+// Usage: makebook [weights] [plies] [depth]
+int main(int argc, char *argv[]) {
+    string weightName = argc > 1 ? argv[1] : DEFAULT_WEIGHTS;
+    int numPlies = argc > 2 ? atoi(argv[2]) : DEFAULT_BOOK_PLIES;
+    int depth = argc > 3 ? atoi(argv[3]) : DEFAULT_BOOK_DEPTH;
+
+    ifstream ifile(weightName);
+    string heuristicType;
+    if(!(ifile >> heuristicType)){
+        cerr << "Error opening file: " << weightName << endl;
+        return 1;
+    }
+    ifile.close();
+
+    string baseName = weightName.substr(0, weightName.rfind('.'));
+    ProbCut parameters;
+    ProbCut* probCut = nullptr;
+    if(parameters.load((baseName + ".probcut").c_str())){
+        probCut = &parameters;
+    }
+
+    vector<BookEntry> entries;
+    if(heuristicType == "time"){
+        TimeHeuristic heuristic(weightName.c_str());
+        entries = buildBook(&heuristic, probCut, numPlies, depth);
+    }
+    else if(heuristicType == "pattern"){
+        PatternHeuristic heuristic(weightName.c_str());
+        entries = buildBook(&heuristic, probCut, numPlies, depth);
+    }
+    else{
+        LinearHeuristic heuristic(weightName.c_str());
+        entries = buildBook(&heuristic, probCut, numPlies, depth);
+    }
+
+    string bookName = baseName + ".book";
+    if(!OpeningBook::write(bookName.c_str(), entries)){
+        return 1;
+    }
+    cerr << "Saved " << entries.size() << " positions to " << bookName << endl;
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "openingBook.hpp"
+
+/**
+ * Constructs a book with no file open, which finds nothing
+ */
+OpeningBook::OpeningBook(){
+    mapping = nullptr;
+    mappingSize = 0;
+    entries = nullptr;
+    numEntries = 0;
+}
+
+OpeningBook::~OpeningBook(){
+    close();
+}
+
+/**
+ * Maps a book file into memory. Nothing is read until the first lookup.
+ * @param  filename Book file to open
+ * @return          False if the file is missing or not a book
+ */
+bool OpeningBook::open(const char* filename){
+    close();
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) < 0 || info.st_size < BOOK_MAGIC_SIZE + 8){
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED){
+        return false;
+    }
+
+    unsigned long long count;
+    memcpy(&count, (char*)data + BOOK_MAGIC_SIZE, 8);
+    if(memcmp(data, BOOK_MAGIC, BOOK_MAGIC_SIZE) != 0 || (unsigned long long)
+            info.st_size != BOOK_MAGIC_SIZE + 8 + count * sizeof(BookEntry)){
+        cerr << "Book file " << filename << " is malformed" << endl;
+        munmap(data, info.st_size);
+        return false;
+    }
+
+    mapping = data;
+    mappingSize = info.st_size;
+    entries = (const BookEntry*)((char*)data + BOOK_MAGIC_SIZE + 8);
+    numEntries = count;
+    return true;
+}
+
+/**
+ * Unmaps the book file, if one is open
+ */
+void OpeningBook::close(){
+    if(mapping){
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    entries = nullptr;
+    numEntries = 0;
+}
+
+unsigned long long OpeningBook::size(){
+    return numEntries;
+}
+
+/**
+ * Builds the entry for a position
+ * @param  board Position
+ * @param  side  Side to move
+ * @param  move  Best move for the side to move
+ * @param  score Score of the best move, from the side to move's view
+ * @param  depth Depth the move was searched to
+ * @return       Entry with the move in the canonical orientation
+ */
+BookEntry OpeningBook::makeEntry(Board* board, bool side, Move move,
+                float score, int depth){
+    BookEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    int symmetry;
+    entry.key = board->getCanonicalKey(side, &symmetry);
+    Move canonical = Board::transformMove(move, symmetry);
+    entry.move = (7 - canonical.getX()) + 8 * (7 - canonical.getY());
+    entry.score = (short)max(-32767.0, min(32767.0, score * BOOK_SCORE_UNIT));
+    entry.depth = depth;
+    return entry;
+}
+
+/**
+ * Writes a book file. Entries are sorted by key and only the first of any
+ * repeated key is kept.
+ * @param  filename File to write
+ * @param  entries  Entries to write, sorted in place
+ * @return          False if the file could not be written
+ */
+bool OpeningBook::write(const char* filename, vector<BookEntry>& entries){
+    stable_sort(entries.begin(), entries.end(),
+        [](const BookEntry& a, const BookEntry& b){ return a.key < b.key; });
+    entries.erase(unique(entries.begin(), entries.end(),
+        [](const BookEntry& a, const BookEntry& b){ return a.key == b.key; }),
+        entries.end());
+
+    ofstream ofile(filename, ios::binary);
+    if(!ofile.is_open()){
+        cerr << "Error opening file: " << filename << endl;
+        return false;
+    }
+    unsigned long long count = entries.size();
+    ofile.write(BOOK_MAGIC, BOOK_MAGIC_SIZE);
+    ofile.write((const char*)&count, 8);
+    ofile.write((const char*)entries.data(), count * sizeof(BookEntry));
+    ofile.close();
+    return ofile.good();
+}
+
+/**
+ * Looks a position up with a binary search over the sorted entries
+ * @param  board Position
+ * @param  side  Side to move
+ * @param  move  Set to the book move if the position is in the book
+ * @param  score Set to the score of the book move
+ * @return       True if the position is in the book with a legal move
+ */
+bool OpeningBook::lookup(Board* board, bool side, Move* move, float* score){
+    if(!numEntries){
+        return false;
+    }
+    int symmetry;
+    unsigned long long key = board->getCanonicalKey(side, &symmetry);
+
+    const BookEntry* entry = lower_bound(entries, entries + numEntries, key,
+        [](const BookEntry& e, unsigned long long k){ return e.key < k; });
+    if(entry == entries + numEntries || entry->key != key){
+        return false;
+    }
+
+    Move bookMove = Board::inverseMove(Move(7 - entry->move % 8,
+                                    7 - entry->move / 8, side), symmetry);
+    if(!board->checkMove(bookMove)){
+        return false;
+    }
+    *move = bookMove;
+    *score = entry->score / BOOK_SCORE_UNIT;
+    return true;
+}
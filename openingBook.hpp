@@ -0,0 +1,63 @@
+#ifndef __OPENINGBOOK_H__
+#define __OPENINGBOOK_H__
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "common.hpp"
+#include "board.hpp"
+using namespace std;
+
+#define BOOK_MAGIC "OTHBOOK1"
+#define BOOK_MAGIC_SIZE 8
+// Scores are stored as fixed point fractions of the heuristic's range
+#define BOOK_SCORE_UNIT 10000.0
+
+/**
+ * One position of the book, 16 bytes. The move is the bit position of the
+ * best move in the canonical orientation of the position.
+ */
+typedef struct {
+    unsigned long long key;
+    short score;
+    unsigned char move;
+    unsigned char depth;
+    unsigned char padding[4];
+} BookEntry;
+
+/**
+ * Opening book read straight from a memory-mapped file, so opening it costs
+ * the same whatever its size. The file is an 8 byte magic string, the number
+ * of entries as a 64 bit integer, then the entries sorted by key.
+ *
+ * Positions are looked up by Board::getCanonicalKey, so each position and its
+ * mirror images share one entry.
+ */
+class OpeningBook {
+
+private:
+    void* mapping;
+    size_t mappingSize;
+    const BookEntry* entries;
+    unsigned long long numEntries;
+
+public:
+    static BookEntry makeEntry(Board* board, bool side, Move move,
+                float score, int depth);
+    static bool write(const char* filename, vector<BookEntry>& entries);
+
+    OpeningBook();
+    ~OpeningBook();
+    bool open(const char* filename);
+    void close();
+    unsigned long long size();
+    bool lookup(Board* board, bool side, Move* move, float* score);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "patternHeuristic.hpp"
+
+PatternHeuristic::PatternHeuristic(const char* filename) {
+    weights = new float[NUM_PATTERN_WEIGHTS];
+
+    offsets[0] = 0;
+    for (int type = 1; type < NUM_PATTERN_TYPES; type++) {
+        offsets[type] = offsets[type - 1] +
+                    (int)pow(3, Board::getPatternSize(type - 1));
+    }
+
+    if (strcmp(filename, "weights/random.weights") == 0) {
+        for (int i = 0; i < NUM_PATTERN_WEIGHTS; i++) {
+            double randVal = ((float)rand())/RAND_MAX;
+            randVal *= 2;
+            randVal -= 1;
+            randVal *= .05;
+            weights[i] = randVal;
+        }
+    }
+    else{
+        ifstream ifile(filename, ios::binary);
+        if(!ifile.is_open()) {
+        cerr << "Error opening file: " << filename << endl;
+            exit(1);
+        }
+
+        string weightsType;
+        ifile >> weightsType;
+        if (weightsType.compare("pattern") != 0) {
+            cerr << "Weights file " << filename << " does not support this heuristic type" << endl;
+            exit(1);
+        }
+        ifile.get();
+
+        // Little-endian 16 bit values follow the header line
+        for (int i = 0; i < NUM_PATTERN_WEIGHTS; i++) {
+            unsigned char bytes[2];
+            if (!ifile.read((char*)bytes, 2)) {
+                cerr << "Weights file " << filename << " is too short" << endl;
+                exit(1);
+            }
+            weights[i] = (short)(bytes[0] | (bytes[1] << 8)) / PATTERN_WEIGHT_UNIT;
+        }
+
+        ifile.close();
+    }
+}
+
+PatternHeuristic::~PatternHeuristic() {
+    delete[] weights;
+}
+
+int PatternHeuristic::getNumWeights(){
+    return NUM_PATTERN_WEIGHTS;
+}
+
+void PatternHeuristic::prepareBoard(Board* board){
+    board->enablePatterns();
+}
+
+void PatternHeuristic::getGrad(Board* board, bool side, double* grad){
+    prepareBoard(board);
+    for (int i = 0; i < NUM_PATTERN_WEIGHTS; i++) {
+        grad[i] = 0;
+    }
+    BoardFeatures features;
+    board->getFeatures(&features, false);
+    if (features.isDone) {
+        return;
+    }
+
+    double t = tanh(getSum(board->getPatterns(), &features, side) / PATTERN_SCALE);
+    double scalar = TANH_MAX * (1 - t * t) / PATTERN_SCALE;
+    if (side != BLACK) {
+        scalar = -scalar;
+    }
+
+    int base = getStage(&features) * PATTERN_STAGE_SIZE;
+    grad[base + MOBILITY_WEIGHT] = scalar *
+                    (features.mobility[BLACK] - features.mobility[WHITE]);
+    for (int i = 0; i < NUM_PATTERNS; i++) {
+        grad[base + offsets[Board::getPatternType(i)] + board->getPattern(i)] += scalar;
+    }
+}
+
+void PatternHeuristic::updateWeights(const double* deltaWeights){
+    for (int i = 0; i < NUM_PATTERN_WEIGHTS; i++) {
+        weights[i] += deltaWeights[i];
+    }
+}
+
+void PatternHeuristic::saveWeights(const char* filename) {
+    writeWeights(filename, weights);
+}
+
+/**
+ * Writes a full set of weights in the format the constructor reads
+ * @param filename File to write
+ * @param weights  NUM_PATTERN_WEIGHTS weights in discs, stage by stage
+ */
+void PatternHeuristic::writeWeights(const char* filename, const float* weights) {
+    ofstream ofile(filename, ios::binary);
+
+    if(!ofile.is_open()) {
+        cerr << "Error opening file: " << filename << endl;
+        exit(1);
+    }
+
+    ofile << "pattern" << endl;
+
+    for (int i = 0; i < NUM_PATTERN_WEIGHTS; i++) {
+        double value = round(weights[i] * PATTERN_WEIGHT_UNIT);
+        short quantized = (short)max(-32767.0, min(32767.0, value));
+        ofile.put((char)(quantized & 0xff));
+        ofile.put((char)((quantized >> 8) & 0xff));
+    }
+
+    ofile.close();
+}
@@ -0,0 +1,125 @@
+#ifndef __PATTERNHEURISTIC_H__
+#define __PATTERNHEURISTIC_H__
+
+#include "common.hpp"
+#include "board.hpp"
+#include "heuristic.hpp"
+#include <fstream>
+#include <math.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Weight tables are kept for every 6 empties
+#define NUM_PATTERN_STAGES 10
+#define PATTERN_STAGE_EMPTIES 6
+// Sum of the table sizes, 3^size for each pattern type
+#define PATTERN_TABLE_SIZE 147582
+// Each stage ends with the weight of the mobility difference
+#define MOBILITY_WEIGHT PATTERN_TABLE_SIZE
+#define PATTERN_STAGE_SIZE (PATTERN_TABLE_SIZE + 1)
+#define NUM_PATTERN_WEIGHTS (NUM_PATTERN_STAGES * PATTERN_STAGE_SIZE)
+// Weights are stored in the file as 16 bit fractions of a disc
+#define PATTERN_WEIGHT_UNIT 256.0
+// Predicted disc difference that maps to a score of tanh(1)
+#define PATTERN_SCALE 32.0
+#define TANH_MAX 0.999
+
+/**
+ * Scores a board by looking up the codes of the edge, corner and diagonal
+ * patterns that Board keeps up to date. Each pattern type has a weight table
+ * for each stage of the game, in units of discs for black; a leaf costs one
+ * load per pattern.
+ */
+class PatternHeuristic final : public Heuristic{
+private:
+    float* weights;
+    int offsets[NUM_PATTERN_TYPES];
+
+    static inline int getStage(BoardFeatures* features);
+    inline float getSum(const unsigned short* codes, BoardFeatures* features,
+                                                            bool side);
+    inline double scoreFeatures(const unsigned short* codes,
+                                BoardFeatures* features, bool side);
+public:
+    PatternHeuristic(const char* filename);
+    ~PatternHeuristic();
+    inline double getScore(Board* board, bool side);
+    void prepareBoard(Board* board);
+    inline void getChildScores(Board* board, bool side,
+                unsigned long long moves, float* scores);
+    int getNumWeights();
+    void getGrad(Board* board, bool side, double* grad);
+    void updateWeights(const double* deltaWeights);
+    void saveWeights(const char* filename);
+    static void writeWeights(const char* filename, const float* weights);
+};
+
+inline int PatternHeuristic::getStage(BoardFeatures* features) {
+    int empties = 64 - features->discs[BLACK] - features->discs[WHITE];
+    return min(empties, NUM_PATTERN_STAGES * PATTERN_STAGE_EMPTIES - 1)
+                                            / PATTERN_STAGE_EMPTIES;
+}
+
+inline float PatternHeuristic::getSum(const unsigned short* codes,
+                                    BoardFeatures* features, bool side) {
+    const float* stageWeights = &weights[getStage(features) * PATTERN_STAGE_SIZE];
+    float sum = stageWeights[MOBILITY_WEIGHT] *
+                    (features->mobility[BLACK] - features->mobility[WHITE]);
+    for (int i = 0; i < NUM_PATTERNS; i++) {
+        sum += stageWeights[offsets[Board::getPatternType(i)] + codes[i]];
+    }
+    return side == BLACK ? sum : -sum;
+}
+
+inline double PatternHeuristic::scoreFeatures(const unsigned short* codes,
+                                    BoardFeatures* features, bool side){
+    if (features->isDone) {
+        int difference = features->discs[side] - features->discs[!side];
+        if (difference > 0) {
+            return 1;
+        }
+        else if (difference == 0) {
+            return 0;
+        }
+        else {
+            return -1;
+        }
+    }
+
+    return TANH_MAX * tanh(getSum(codes, features, side) / PATTERN_SCALE);
+}
+
+inline double PatternHeuristic::getScore(Board* board, bool side){
+    // Stability is not part of the evaluation
+    BoardFeatures features;
+    board->getFeatures(&features, false);
+    return scoreFeatures(board->getPatterns(), &features, side);
+}
+
+/**
+ * Scores every position one move away. The children's codes are the
+ * parent's with the digits of each move's squares changed, so no move is
+ * made.
+ * @param board  Position to move from
+ * @param side   Side making the moves, whose view the scores are from
+ * @param moves  Grid of bits with the moves to score set
+ * @param scores Set to the score of each move, highest bit first
+ */
+inline void PatternHeuristic::getChildScores(Board* board, bool side,
+                        unsigned long long moves, float* scores){
+    BoardFeatures features[MAX_MOVES];
+    unsigned long long flips[MAX_MOVES];
+    int n = board->getChildFeatures(side, moves, features, false, flips);
+    unsigned short codes[NUM_PATTERNS + 1];
+    for (int i = 0; i < n; i++) {
+        int pos = 63 - __builtin_clzll(moves);
+        moves ^= 0x1ULL << pos;
+        board->getChildPatterns(side, pos, flips[i], codes);
+        scores[i] = scoreFeatures(codes, &features[i], side);
+    }
+}
+
+#endif
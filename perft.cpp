@@ -0,0 +1,141 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include "common.hpp"
+#include "board.hpp"
+
+#define DEFAULT_DEPTH 9
+
+// Leaf counts from the starting position for depths 1 to 11. A pass counts as
+// a move, and a finished game is a leaf at whatever depth it ends.
+static const unsigned long long startNodes[] = {
+    4ULL, 12ULL, 56ULL, 244ULL, 1396ULL, 8200ULL, 55092ULL, 390216ULL,
+    3005288ULL, 24571284ULL, 212258800ULL
+};
+#define NUM_START_NODES 11
+
+typedef struct {
+    const char* data;
+    bool side;
+    int depth;
+    unsigned long long nodes;
+} PerftPosition;
+
+// Positions from random games in Board::setBoard format, with leaf counts from
+// the original copy-per-node board. The last two run into passes and the end
+// of the game.
+static const PerftPosition positions[] = {
+    {"----w-----ww-----wwwb-b----bbbbb--bwbb----w--bw--w----b-w------b",
+                                                BLACK, 6, 834359ULL},
+    {"-wwb-b--bwbbbw---wbbbbbbwwbbbbb-w-wbbbb-w--bwwbb--b-bw------b---",
+                                                BLACK, 6, 1032150ULL},
+    {"-bbb----bb-w-bbb-bwwwwbwbwbwwwwwwwwbbwww-wbbbbbb-bbbwbb----b-wb-",
+                                                BLACK, 8, 12361692ULL},
+    {"-b-bbbw---bwbbbb-b-bbbbw-bwwwwwwwwwwbbb-bwwwwwww-bwwwbwwbbbbbbbw",
+                                                BLACK, 11, 224767ULL},
+    {"-wwwwbb-wwwwbwwwbbbwbbbbbbwwwwbb-b-wwwwb-bbwbwwb-wbbbbbbwwwwbbbb",
+                                                BLACK, 11, 158ULL}
+};
+#define NUM_POSITIONS 5
+
+/**
+ * Counts the leaves of the game tree below a position, making and taking back
+ * every move in place
+ * @param  board  Position to count from
+ * @param  side   Side to move
+ * @param  depth  Number of plies to count to
+ * @param  passed True if the last move was a pass
+ * @return        Number of leaves
+ */
+static unsigned long long perft(Board* board, bool side, int depth, bool passed){
+    if(depth == 0){
+        return 1;
+    }
+    MoveList moves = board->possibleMoves(side);
+    if(moves[0].isNull() && passed){
+        return 1;
+    }
+    // Every move, including a single pass, leads to exactly one leaf
+    if(depth == 1){
+        return moves.size();
+    }
+
+    unsigned long long nodes = 0;
+    for(int i = 0; i < moves.size(); i++){
+        unsigned long long flips = board->doMove(moves[i]);
+        nodes += perft(board, !side, depth - 1, moves[i].isNull());
+        board->undoMove(moves[i], flips);
+    }
+    return nodes;
+}
+
+/**
+ * Runs perft on a position and reports the count and speed
+ * @param  board    Position to count from
+ * @param  side     Side to move
+ * @param  depth    Number of plies to count to
+ * @param  expected Known leaf count, or 0 if unknown
+ * @return          False if the count is wrong or the position was not
+ *                  restored afterwards
+ */
+static bool runPerft(Board* board, bool side, int depth, unsigned long long expected){
+    unsigned long long hash = board->getHash();
+    unsigned long long black = board->getPieces(BLACK);
+    unsigned long long white = board->getPieces(WHITE);
+
+    auto start = chrono::steady_clock::now();
+    unsigned long long nodes = perft(board, side, depth, false);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    bool isRestored = board->getHash() == hash && board->getPieces(BLACK) == black
+                                              && board->getPieces(WHITE) == white;
+    bool isCorrect = isRestored && (expected == 0 || nodes == expected);
+
+    cout << setw(3) << depth << setw(14) << nodes << setw(10) << fixed
+         << setprecision(3) << seconds << " s" << setw(10) << setprecision(2)
+         << (seconds > 0 ? nodes / seconds / 1e6 : 0) << " Mn/s  ";
+    if(!isRestored){
+        cout << "FAIL (board not restored)";
+    }
+    else if(expected == 0){
+        cout << "-";
+    }
+    else if(isCorrect){
+        cout << "ok";
+    }
+    else{
+        cout << "FAIL (expected " << expected << ")";
+    }
+    cout << endl;
+    return isCorrect;
+}
+
+// Validates and times move generation and make/unmake in Board. Counts the
+// starting position up to the given depth, then each test position.
+int main(int argc, char *argv[]) {
+    int maxDepth = argc > 1 ? atoi(argv[1]) : DEFAULT_DEPTH;
+    bool isPassing = true;
+
+    cout << "Start position" << endl;
+    for(int depth = 1; depth <= maxDepth; depth++){
+        Board board;
+        unsigned long long expected = depth <= NUM_START_NODES ? startNodes[depth - 1] : 0;
+        isPassing &= runPerft(&board, BLACK, depth, expected);
+    }
+
+    for(int i = 0; i < NUM_POSITIONS; i++){
+        cout << "Position " << i + 1 << endl;
+        Board board;
+        char data[64];
+        for(int j = 0; j < 64; j++){
+            data[j] = positions[i].data[j];
+        }
+        board.setBoard(data);
+        isPassing &= runPerft(&board, positions[i].side, positions[i].depth,
+                                                    positions[i].nodes);
+    }
+
+    cout << (isPassing ? "All counts match" : "MISMATCH") << endl;
+    return isPassing ? 0 : 1;
+}
@@ -3,9 +3,9 @@
 /*
  * Constructor for the player; initialize everything here. The side your AI is
  * on (BLACK or WHITE) is passed in as "side". The constructor must finish
- * within 30 seconds.
+ * within 30 seconds. Midgame searches run on numThreads threads.
  */
-Player::Player(bool side, char* weightName) {
+Player::Player(bool side, char* weightName, int numThreads) {
 
     othelloBoard = new Board();
 
@@ -13,41 +13,67 @@ Player::Player(bool side, char* weightName) {
     otherSide = !side;
 
     movesPlayed = 0;
-    endGameHead = nullptr;
+    isEndGameSolved = false;
+    this->numThreads = max(numThreads, 1);
+    isPonderEnabled = false;
+    ponderStop.store(false);
+    lastSearchDepth = SEARCH_DEPTH;
+    statsLog = &cerr;
 
     ifstream ifile(weightName);
     if(!ifile.is_open()) {
     cerr << "Error opening file: " << weightName << endl;
         exit(1);
     }
-    string heuristicType;
-    ifile >> heuristicType;
+    string weightsType;
+    ifile >> weightsType;
     ifile.close();
 
-    if (heuristicType.compare("linear") == 0) {
+    if (weightsType.compare("linear") == 0) {
         mainHeuristic = new LinearHeuristic(weightName);
+        heuristicType = LINEAR_HEURISTIC;
     }
-    else if (heuristicType.compare("time") == 0) {
+    else if (weightsType.compare("time") == 0) {
         mainHeuristic = new TimeHeuristic(weightName);
+        heuristicType = TIME_HEURISTIC;
+    }
+    else if (weightsType.compare("pattern") == 0) {
+        mainHeuristic = new PatternHeuristic(weightName);
+        heuristicType = PATTERN_HEURISTIC;
     }
     else {
-        cerr << "Heuristic type \"" << heuristicType << "\" not supported." << endl;
+        cerr << "Heuristic type \"" << weightsType << "\" not supported." << endl;
         exit(1);
     }
 
-    endgameHeuristic = new LinearHeuristic("weights/endgame.weights");
+    endgameSolver = new EndgameSolver(this->numThreads);
+
+    // Full width until setProbCut is given parameters
+    probCut = nullptr;
+
+    // Opening book built for these weights by makebook, if any
+    string bookName(weightName);
+    bookName = bookName.substr(0, bookName.rfind('.')) + ".book";
+    book = new OpeningBook();
+    if(!book->open(bookName.c_str())){
+        delete book;
+        book = nullptr;
+    }
 
-    transTable = new TransTableEntry[NUM_T_TABLE_ENTRIES]();
+    transTable = new TransTable(NUM_T_TABLE_ENTRIES);
 }
 
 /*
  * Destructor for the player.
  */
 Player::~Player() {
+    stopPondering(NULL_MOVE(otherSide));
     delete othelloBoard;
     delete mainHeuristic;
-    delete endgameHeuristic;
-    if (transTable) delete transTable;
+    delete endgameSolver;
+    delete transTable;
+    delete probCut;
+    delete book;
 }
 
 /**
@@ -58,6 +84,74 @@ void Player::setBoard(Board* b){
     othelloBoard = b;
 }
 
+/**
+ * Turns pondering on or off. When on, the player keeps searching on the
+ * opponent's time after each move.
+ * @param isEnabled Whether to ponder
+ */
+void Player::setPonder(bool isEnabled){
+    isPonderEnabled = isEnabled;
+}
+
+/**
+ * Makes the midgame search selective with Multi-ProbCut
+ * @param  filename Parameters fitted for the player's weights by calibrate
+ * @return          False if the file could not be read
+ */
+bool Player::setProbCut(const char* filename){
+    ProbCut* parameters = new ProbCut();
+    if(!parameters->load(filename)){
+        delete parameters;
+        return false;
+    }
+    delete probCut;
+    probCut = parameters;
+    return true;
+}
+
+/**
+ * Sends the search statistics of each move somewhere other than stderr
+ * @param  filename File to append one JSON line per move to, or nullptr to
+ *                  stop writing statistics
+ * @return          False if the file could not be opened
+ */
+bool Player::setStatsLog(const char* filename){
+    if(!filename){
+        statsLog = nullptr;
+        return true;
+    }
+    statsFile.open(filename, ios::app);
+    if(!statsFile.is_open()){
+        return false;
+    }
+    statsLog = &statsFile;
+    return true;
+}
+
+/**
+ * Writes the statistics of the move just made as one JSON line
+ * @param move   Move that was made
+ * @param source What decided the move: book, ponder, search or endgame
+ * @param ms     Time the move took
+ */
+void Player::writeStats(Move move, const char* source, int ms){
+    if(!statsLog){
+        return;
+    }
+    *statsLog << "{\"side\":\"" << (ourSide==BLACK ? "Black" : "White")
+        << "\",\"ply\":" << movesPlayed
+        << ",\"source\":\"" << source << "\",\"move\":";
+    if(move.isNull()){
+        *statsLog << "null";
+    }
+    else{
+        *statsLog << "[" << move.getX() << "," << move.getY() << "]";
+    }
+    *statsLog << ",\"ms\":" << ms << ",\"threads\":" << numThreads << ",";
+    moveStats.writeFields(*statsLog);
+    *statsLog << "}" << endl;
+}
+
 
 /*
  * Compute the next move given the opponent's last move. Your AI is
@@ -74,6 +168,11 @@ void Player::setBoard(Board* b){
  */
 Move Player::doMove(Move opponentsMove, int msLeft) {
 
+    bool isPonderHit = stopPondering(opponentsMove);
+    auto start = chrono::steady_clock::now();
+    moveStats.reset();
+    const char* source = "search";
+
     if(!opponentsMove.isNull()){
         movesPlayed ++;
     }
@@ -82,14 +181,33 @@ Move Player::doMove(Move opponentsMove, int msLeft) {
 
     Move moveToMake = NULL_MOVE(ourSide);
 
-    if(movesPlayed < 40){
-        moveToMake = minimax(mainHeuristic, 10, msLeft);
+    int empties = 64 - othelloBoard->count(BLACK) - othelloBoard->count(WHITE);
+    float bookScore;
+    if(empties > WLD_EMPTIES && book
+            && book->lookup(othelloBoard, ourSide, &moveToMake, &bookScore)){
+        cerr << "sudormrf-" << (ourSide==BLACK ? "Black" : "White") << ": "
+            << "book move, score " << bookScore << endl;
+        source = "book";
+    }
+    else if(empties > WLD_EMPTIES && isPonderHit && ponderDepth >=
+                                (msLeft < 0 ? SEARCH_DEPTH : lastSearchDepth)){
+        cerr << "sudormrf-" << (ourSide==BLACK ? "Black" : "White") << ": "
+            << "ponder hit, depth " << ponderDepth << endl;
+        moveToMake = ponderResult;
+        source = "ponder";
+    }
+    else if(empties > WLD_EMPTIES){
+        moveToMake = midGameSearch(msLeft);
+        if(msLeft >= 0){
+            lastSearchDepth = moveStats.getDepthReached();
+        }
     }
-    else if(movesPlayed >= 60){
+    else if(empties == 0){
         moveToMake = NULL_MOVE(ourSide);
     }
     else{
         moveToMake = endGameSolve(opponentsMove, msLeft);
+        source = "endgame";
     }
 
     othelloBoard->doMove(moveToMake);
@@ -106,69 +224,210 @@ Move Player::doMove(Move opponentsMove, int msLeft) {
         movesPlayed ++;
     }
 
+    writeStats(moveToMake, source, (int)chrono::duration_cast<chrono::milliseconds>(
+                                chrono::steady_clock::now() - start).count());
+
+    if(isPonderEnabled){
+        startPondering(msLeft);
+    }
+
     return moveToMake;
 }
 
 /**
- * Determines the move to make during the early/mid game using minimax
+ * Searches on the opponent's time until stopPondering. A shallow search
+ * predicts the opponent's reply, then our answer to it is searched with
+ * iterative deepening. Either way the transposition table is left full of
+ * results that the search for our next move can reuse.
+ * @param heuristic Heuristic function to use for this search
+ */
+template<class H>
+void Player::ponder(H* heuristic){
+    BoardNode opponent(&ponderBoard, otherSide);
+    opponent.setHelper(0, &ponderStop);
+    opponent.setProbCut(probCut);
+    Move prediction = opponent.getBestChoice(PONDER_PREDICT_DEPTH, heuristic,
+                                                                transTable);
+    if(ponderStop.load()){
+        return;
+    }
+
+    Board predicted = ponderBoard;
+    predicted.doMove(prediction);
+    BoardNode root(&predicted, ourSide);
+    root.setHelper(0, &ponderStop);
+    root.setProbCut(probCut);
+    Move result = root.getBestChoice(ponderMaxDepth, heuristic, transTable);
+    ponderPrediction = prediction;
+    ponderResult = result;
+    ponderDepth = root.getDepthReached();
+}
+
+/**
+ * Starts pondering on a background thread, unless the game is over or our
+ * next move will be left to the endgame solver. Without a clock there is no
+ * use searching deeper than the next move's search will go.
+ * @param msLeft Time remaining to make moves
+ */
+void Player::startPondering(int msLeft){
+    int empties = 64 - othelloBoard->count(BLACK) - othelloBoard->count(WHITE);
+    if(empties - 1 <= WLD_EMPTIES || othelloBoard->isDone()){
+        return;
+    }
+
+    ponderBoard = *othelloBoard;
+    ponderPrediction = NULL_MOVE(otherSide);
+    ponderDepth = 0;
+    ponderMaxDepth = msLeft < 0 ? SEARCH_DEPTH : empties;
+    ponderStop.store(false);
+    transTable->newSearch();
+    switch(heuristicType){
+        case TIME_HEURISTIC:
+            ponderThread = thread(&Player::ponder<TimeHeuristic>, this,
+                                        (TimeHeuristic*)mainHeuristic);
+            break;
+        case PATTERN_HEURISTIC:
+            ponderThread = thread(&Player::ponder<PatternHeuristic>, this,
+                                        (PatternHeuristic*)mainHeuristic);
+            break;
+        default:
+            ponderThread = thread(&Player::ponder<LinearHeuristic>, this,
+                                        (LinearHeuristic*)mainHeuristic);
+            break;
+    }
+}
+
+/**
+ * Stops pondering, if the player is, and waits for the search to finish
+ * @param  opponentsMove Move the opponent actually made
+ * @return               True if the opponent made the predicted move and the
+ *                       pondering search finished at least one iteration
+ */
+bool Player::stopPondering(Move opponentsMove){
+    if(!ponderThread.joinable()){
+        return false;
+    }
+    ponderStop.store(true);
+    ponderThread.join();
+    return ponderDepth > 0 && ponderPrediction == opponentsMove;
+}
+
+/**
+ * Splits the remaining clock over the moves we still have to play
+ * @param  msLeft Time remaining to make moves
+ * @return        Milliseconds this move should take
+ */
+int Player::getTimeBudget(int msLeft){
+    int empties = 64 - othelloBoard->count(BLACK) - othelloBoard->count(WHITE);
+    int movesLeft = (empties + 1) / 2;
+    return msLeft / (movesLeft + TIME_RESERVE_MOVES);
+}
+
+/**
+ * Determines the move to make during the early/mid game using iterative
+ * deepening. Without a clock the search goes to a fixed depth. With one, it
+ * stops starting new iterations after half the move's budget and aborts at
+ * twice the budget, never using more than a quarter of the clock. Weights
+ * that come with calibrated Multi-ProbCut parameters get a selective search.
+ *
+ * With more than one thread, helper searches of the same position run until
+ * the main search finishes (lazy SMP). They only share the transposition
+ * table, which fills it with results the main search can cut short with.
  * @param  heuristic Heuristic function to use for this search
- * @param  depth     Depth to search into minimax tree
  * @param  msLeft    Time remaining to make moves
  * @return           Move to make
  */
-Move Player::minimax(Heuristic* heuristic, int depth, int msLeft){
-    BoardNode* root = new BoardNode(othelloBoard, ourSide);
-    Move test = root->getBestChoice(depth, heuristic, transTable);
-    delete root;
-    return test;
+template<class H>
+Move Player::minimax(H* heuristic, int msLeft){
+    BoardNode root(othelloBoard, ourSide);
+    root.setProbCut(probCut);
+    int maxDepth = SEARCH_DEPTH;
+    if(msLeft >= 0){
+        int budget = getTimeBudget(msLeft);
+        root.setTimeLimit(budget / 2, min(budget * 2, msLeft / 4));
+        maxDepth = 64 - othelloBoard->count(BLACK) - othelloBoard->count(WHITE);
+    }
+
+    transTable->newSearch();
+
+    atomic<bool> stop(false);
+    vector<BoardNode*> helpers;
+    vector<thread> threads;
+    for(int i = 1; i < numThreads; i++){
+        BoardNode* helper = new BoardNode(othelloBoard, ourSide);
+        helper->setHelper(i, &stop);
+        helper->setProbCut(probCut);
+        helpers.push_back(helper);
+        threads.push_back(thread(&BoardNode::getBestChoice<H>, helper, maxDepth,
+                                                    heuristic, transTable));
+    }
+
+    Move ret = root.getBestChoice(maxDepth, heuristic, transTable);
+
+    stop.store(true);
+    moveStats.add(root.getStats());
+    for(int i = 0; i < (int)threads.size(); i++){
+        threads[i].join();
+        moveStats.add(helpers[i]->getStats());
+        delete helpers[i];
+    }
+    return ret;
+}
+
+/**
+ * Runs the midgame search with the search instantiated for our heuristic
+ * @param  msLeft Time remaining to make moves
+ * @return        Move to make
+ */
+Move Player::midGameSearch(int msLeft){
+    switch(heuristicType){
+        case TIME_HEURISTIC:
+            return minimax((TimeHeuristic*)mainHeuristic, msLeft);
+        case PATTERN_HEURISTIC:
+            return minimax((PatternHeuristic*)mainHeuristic, msLeft);
+        default:
+            return minimax((LinearHeuristic*)mainHeuristic, msLeft);
+    }
 }
 
 /**
- * Determines the move to make during endgame using an endgame solver
+ * Determines the move to make during endgame using the endgame solver. Up to
+ * WLD_EMPTIES empties the solver only proves a win, draw or loss; up to
+ * EXACT_EMPTIES it finds the exact disc difference. A move proven to win or
+ * draw is played. A proven loss or a solve that runs out of time falls back to
+ * the midgame search, except in exact mode where the solver's move loses by
+ * the least. The solver runs on as many threads as the midgame search.
  * @param  opponentsMove Move that the opponent made last round
  * @param  msLeft        Time remaining to make moves
  * @return               Move to make
  */
 Move Player::endGameSolve(Move opponentsMove, int msLeft){
-    if(endGameHead == nullptr){
-        delete[] transTable;
-        transTable = nullptr;
-        endGameHead = new BoardNode(othelloBoard, ourSide);
-        int score = endGameHead->searchTreeEndGame(endgameHeuristic, ourSide);
-        if(score < 1){
-            cerr << "sudormrf-" << (ourSide==BLACK ? "Black" : "White") << ": "
-                << "No solution found" << endl;
-            delete endGameHead;
-            endGameHead = nullptr;
-            transTable = new TransTableEntry[NUM_T_TABLE_ENTRIES]();
-            return minimax(mainHeuristic, 10, msLeft);
-        }
-        cerr << "sudormrf-" << (ourSide==BLACK ? "Black" : "White") << ": "
-            << "CHOKEHOLD SOLUTION FOUND" << endl;
-        endGameTracker = endGameHead->getChildren()[0];
-        return endGameTracker->getMove();
+    int empties = 64 - othelloBoard->count(BLACK) - othelloBoard->count(WHITE);
+    bool isExact = empties <= EXACT_EMPTIES;
+    if(msLeft >= 0){
+        endgameSolver->setTimeLimit(min(ENDGAME_TIME_LIMIT, getTimeBudget(msLeft) * 3));
     }
     else{
-        vector<BoardNode*> nodes = endGameTracker->getChildren();
-        if(opponentsMove.isNull()){
-            endGameTracker = endGameTracker->getChildren()[0];
-        }
-        else{
-            for(int i = 0; i < (int)nodes.size(); i++){
-
-                Move temp = nodes[i]->getMove();
-                if(temp.getX() == opponentsMove.getX() && temp.getY() == opponentsMove.getY()){
-                    endGameTracker = endGameTracker->getChildren()[i];
-                    break;
-                }
-            }
-        }
-        if(endGameTracker->getChildren().size() == 0){
-            return NULL_MOVE(ourSide);
-        }
-        else{
-            endGameTracker = endGameTracker->getChildren()[0];
-            return endGameTracker->getMove();
-        }
+        endgameSolver->setTimeLimit(ENDGAME_TIME_LIMIT);
+    }
+
+    auto start = chrono::steady_clock::now();
+    Move move = NULL_MOVE(ourSide);
+    int score = endgameSolver->solve(othelloBoard, ourSide, isExact, &move);
+    int elapsed = (int)chrono::duration_cast<chrono::milliseconds>(
+                            chrono::steady_clock::now() - start).count();
+    moveStats.endgameNodes += endgameSolver->getNodeCount();
+    moveStats.endgameMs += elapsed;
+
+    if(endgameSolver->wasAborted() || (score < 0 && !isExact)){
+        cerr << "sudormrf-" << (ourSide==BLACK ? "Black" : "White") << ": "
+            << "No solution found" << endl;
+        return midGameSearch(msLeft < 0 ? msLeft : max(msLeft - elapsed, 0));
+    }
+    if(score > 0 && !isEndGameSolved){
+        cerr << "sudormrf-" << (ourSide==BLACK ? "Black" : "White") << ": "
+            << "CHOKEHOLD SOLUTION FOUND" << endl;
+        isEndGameSolved = true;
     }
+    return move;
 }
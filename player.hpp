@@ -4,30 +4,83 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "common.hpp"
 #include "board.hpp"
 #include "boardNode.hpp"
+#include "transTable.hpp"
+#include "endgameSolver.hpp"
+#include "probCut.hpp"
+#include "openingBook.hpp"
 #include "linearHeuristic.hpp"
 #include "timeHeuristic.hpp"
+#include "patternHeuristic.hpp"
+#include "searchStats.hpp"
 using namespace std;
 
+// Depth searched when there is no clock
+#define SEARCH_DEPTH 10
+// Extra moves the clock is split over, kept as a safety margin
+#define TIME_RESERVE_MOVES 3
+// Longest the endgame solver may run before falling back to search
+#define ENDGAME_TIME_LIMIT 60000
+// Empties at which the solver takes over, proving wins/draws/losses only
+#define WLD_EMPTIES 22
+// Empties at which the solver finds the exact final disc difference
+#define EXACT_EMPTIES 18
+// Depth of the search that predicts the opponent's reply when pondering
+#define PONDER_PREDICT_DEPTH 6
+
+enum HeuristicType {LINEAR_HEURISTIC, TIME_HEURISTIC, PATTERN_HEURISTIC};
+
 class Player {
 private:
-    Move minimax(Heuristic* heuristic, int depth, int msLeft);
+    template<class H>
+    Move minimax(H* heuristic, int msLeft);
+    Move midGameSearch(int msLeft);
+    int getTimeBudget(int msLeft);
     Move endGameSolve(Move opponentsMove, int msLeft);
+    template<class H>
+    void ponder(H* heuristic);
+    void startPondering(int msLeft);
+    bool stopPondering(Move opponentsMove);
     Board* othelloBoard;
     int movesPlayed;
     bool ourSide;
     bool otherSide;
-    BoardNode* endGameHead;
-    BoardNode* endGameTracker;
+    bool isEndGameSolved;
     Heuristic* mainHeuristic;
-    Heuristic* endgameHeuristic;
-    TransTableEntry* transTable;
+    HeuristicType heuristicType;
+    EndgameSolver* endgameSolver;
+    TransTable* transTable;
+    ProbCut* probCut;
+    OpeningBook* book;
+    int numThreads;
+    bool isPonderEnabled;
+    thread ponderThread;
+    atomic<bool> ponderStop;
+    Board ponderBoard;
+    Move ponderPrediction;
+    Move ponderResult;
+    int ponderDepth;
+    int ponderMaxDepth;
+    // Depth our last timed search reached, which the next one is expected to
+    // reach as well
+    int lastSearchDepth;
+    SearchStats moveStats;
+    ostream* statsLog;
+    ofstream statsFile;
+    void writeStats(Move move, const char* source, int ms);
 public:
-    Player(bool side, char* weightName);
+    Player(bool side, char* weightName, int numThreads = 1);
     ~Player();
     void setBoard(Board* b);
+    void setPonder(bool isEnabled);
+    bool setProbCut(const char* filename);
+    bool setStatsLog(const char* filename);
     Move doMove(Move opponentsMove, int msLeft);
 };
 
@@ -0,0 +1,165 @@
+#include "probCut.hpp"
+
+/**
+ * Constructs a set of parameters with no calibrated pairs, which never cuts
+ */
+ProbCut::ProbCut(){
+    maxDepth = 0;
+    for(int stage = 0; stage < NUM_PROBCUT_STAGES; stage++){
+        for(int deep = 0; deep <= MAX_PROBCUT_DEPTH; deep++){
+            for(int shallow = 0; shallow <= MAX_PROBCUT_DEPTH; shallow++){
+                fits[stage][deep][shallow].sigma = -1;
+            }
+        }
+    }
+}
+
+ProbCut::~ProbCut(){
+}
+
+/**
+ * Finds the stage of the game that parameters are kept for
+ * @param  empties Empty squares on the board
+ * @return         Stage, 0 for the last empties
+ */
+int ProbCut::getStage(int empties){
+    return min(empties, NUM_PROBCUT_STAGES * PROBCUT_STAGE_EMPTIES - 1)
+                                            / PROBCUT_STAGE_EMPTIES;
+}
+
+/**
+ * Picks the shallow searches that stand in for a deep one. The main check
+ * searches about half as deep, keeping the parity of the depth so both
+ * searches end on the same side; the one before it is two plies shallower.
+ * @param  depth Depth of the deep search
+ * @param  check Which check, 0 for the cheapest
+ * @return       Depth of the shallow search, or -1 if there is none
+ */
+int ProbCut::getShallowDepth(int depth, int check){
+    int shallow = depth / 2;
+    if((depth - shallow) % 2){
+        shallow--;
+    }
+    shallow -= 2 * (NUM_PROBCUT_CHECKS - 1 - check);
+    return shallow >= 1 ? shallow : -1;
+}
+
+/**
+ * Reads parameters written by save
+ * @param  filename File to read
+ * @return          False if the file is missing or malformed, in which case
+ *                  nothing is cut
+ */
+bool ProbCut::load(const char* filename){
+    ifstream ifile(filename);
+    if(!ifile.is_open()){
+        return false;
+    }
+
+    string type;
+    ifile >> type;
+    if(type.compare("probcut") != 0){
+        cerr << "Parameters file " << filename << " is not for probcut" << endl;
+        return false;
+    }
+
+    int depth;
+    ifile >> depth;
+    int stage, deep, shallow;
+    float slope, intercept, sigma;
+    while(ifile >> stage >> deep >> shallow >> slope >> intercept >> sigma){
+        if(stage < 0 || stage >= NUM_PROBCUT_STAGES || shallow < 0
+                || shallow >= deep || deep > MAX_PROBCUT_DEPTH){
+            cerr << "Parameters file " << filename << " is malformed" << endl;
+            *this = ProbCut();
+            return false;
+        }
+        setFit(stage, deep, shallow, slope, intercept, sigma);
+    }
+    maxDepth = min(depth, MAX_PROBCUT_DEPTH);
+    return true;
+}
+
+/**
+ * Writes every calibrated pair, one per line
+ * @param filename File to write
+ */
+void ProbCut::save(const char* filename){
+    ofstream ofile(filename);
+    if(!ofile.is_open()){
+        cerr << "Error opening file: " << filename << endl;
+        exit(1);
+    }
+
+    ofile << "probcut" << endl << maxDepth << endl;
+    for(int stage = 0; stage < NUM_PROBCUT_STAGES; stage++){
+        for(int deep = 1; deep <= maxDepth; deep++){
+            for(int shallow = 0; shallow < deep; shallow++){
+                Fit& fit = fits[stage][deep][shallow];
+                if(fit.sigma >= 0){
+                    ofile << stage << " " << deep << " " << shallow << " "
+                          << fit.slope << " " << fit.intercept << " "
+                          << fit.sigma << endl;
+                }
+            }
+        }
+    }
+    ofile.close();
+}
+
+/**
+ * Sets the model of a deep score given a shallow one
+ * @param stage     Stage of the game
+ * @param deep      Depth of the deep search
+ * @param shallow   Depth of the shallow search
+ * @param slope     Deep score per unit of shallow score
+ * @param intercept Deep score for a shallow score of 0
+ * @param sigma     Standard deviation of the deep score around the model
+ */
+void ProbCut::setFit(int stage, int deep, int shallow, float slope,
+                                    float intercept, float sigma){
+    fits[stage][deep][shallow].slope = slope;
+    fits[stage][deep][shallow].intercept = intercept;
+    fits[stage][deep][shallow].sigma = sigma;
+    maxDepth = max(maxDepth, deep);
+}
+
+int ProbCut::getMaxDepth(){
+    return maxDepth;
+}
+
+/**
+ * Finds the shallow scores beyond which a deep search is expected to fail
+ * high or low. Deep searches past the calibrated depths use the deepest pair
+ * of the same parity that is as far apart.
+ * @param  empties Empty squares on the board
+ * @param  depth   Depth of the deep search
+ * @param  shallow Depth of the shallow search
+ * @param  alpha   Lower bound of the deep search's window
+ * @param  beta    Upper bound of the deep search's window
+ * @param  lower   Set to the shallow score at or below which to fail low
+ * @param  upper   Set to the shallow score at or above which to fail high
+ * @return         False if the pair is not calibrated for this stage
+ */
+bool ProbCut::getCutBounds(int empties, int depth, int shallow, float alpha,
+                            float beta, float* lower, float* upper){
+    if(maxDepth < MIN_PROBCUT_DEPTH){
+        return false;
+    }
+    if(depth > maxDepth){
+        int deep = maxDepth - (depth - maxDepth) % 2;
+        shallow -= depth - deep;
+        depth = deep;
+        if(shallow < 0){
+            return false;
+        }
+    }
+
+    Fit& fit = fits[getStage(empties)][depth][shallow];
+    if(fit.sigma < 0 || fit.slope <= 0){
+        return false;
+    }
+    *lower = (alpha - PROBCUT_THRESHOLD * fit.sigma - fit.intercept) / fit.slope;
+    *upper = (beta + PROBCUT_THRESHOLD * fit.sigma - fit.intercept) / fit.slope;
+    return true;
+}
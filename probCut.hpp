@@ -0,0 +1,62 @@
+#ifndef __PROBCUT_H__
+#define __PROBCUT_H__
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cmath>
+#include "common.hpp"
+using namespace std;
+
+// Parameters are kept for every 6 empties, like the pattern weights
+#define NUM_PROBCUT_STAGES 10
+#define PROBCUT_STAGE_EMPTIES 6
+// Deepest search that score pairs are calibrated for
+#define MAX_PROBCUT_DEPTH 12
+// Shallowest search that is tried for a cut
+#define MIN_PROBCUT_DEPTH 3
+// Shallow searches tried in turn before a deep one, cheapest first
+#define NUM_PROBCUT_CHECKS 2
+// Standard deviations a shallow score has to clear for a cut
+#define PROBCUT_THRESHOLD 1.5
+// Stages with fewer calibration samples than this are never cut
+#define MIN_PROBCUT_SAMPLES 50
+
+/**
+ * Multi-ProbCut parameters. For each stage of the game and each pair of a deep
+ * and a shallow search depth, the deep score is modelled as a linear function
+ * of the shallow score plus normally distributed noise. A shallow search that
+ * clears a bound with enough confidence stands in for the deep search.
+ *
+ * Parameters are fitted for one heuristic by the calibrate tool and read from
+ * a text file next to its weights.
+ */
+class ProbCut {
+
+private:
+    typedef struct {
+        float slope;
+        float intercept;
+        // Negative when the pair has not been calibrated
+        float sigma;
+    } Fit;
+
+    Fit fits[NUM_PROBCUT_STAGES][MAX_PROBCUT_DEPTH + 1][MAX_PROBCUT_DEPTH + 1];
+    int maxDepth;
+
+public:
+    static int getStage(int empties);
+    static int getShallowDepth(int depth, int check);
+
+    ProbCut();
+    ~ProbCut();
+    bool load(const char* filename);
+    void save(const char* filename);
+    void setFit(int stage, int deep, int shallow, float slope,
+                                    float intercept, float sigma);
+    int getMaxDepth();
+    bool getCutBounds(int empties, int depth, int shallow, float alpha,
+                            float beta, float* lower, float* upper);
+};
+
+#endif
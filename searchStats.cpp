@@ -0,0 +1,137 @@
+#include "searchStats.hpp"
+
+/**
+ * Constructs statistics with every count at zero
+ */
+SearchStats::SearchStats(){
+    reset();
+}
+
+SearchStats::~SearchStats(){
+}
+
+/**
+ * Sets every count back to zero
+ */
+void SearchStats::reset(){
+    nodes = 0;
+    interiorNodes = 0;
+    leafNodes = 0;
+    evaluations = 0;
+    ttProbes = 0;
+    ttHits = 0;
+    ttCutoffs = 0;
+    cutoffs = 0;
+    for(int i = 0; i < NUM_CUTOFF_BUCKETS; i++){
+        cutoffIndex[i] = 0;
+    }
+    endgameNodes = 0;
+    endgameMs = 0;
+    numIterations = 0;
+}
+
+/**
+ * Adds the counts of another search, such as a helper thread's. Iterations
+ * are only taken over when none have been recorded here, since the
+ * iterations of parallel searches overlap in time.
+ * @param other Statistics to add
+ */
+void SearchStats::add(const SearchStats& other){
+    nodes += other.nodes;
+    interiorNodes += other.interiorNodes;
+    leafNodes += other.leafNodes;
+    evaluations += other.evaluations;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    cutoffs += other.cutoffs;
+    for(int i = 0; i < NUM_CUTOFF_BUCKETS; i++){
+        cutoffIndex[i] += other.cutoffIndex[i];
+    }
+    endgameNodes += other.endgameNodes;
+    endgameMs += other.endgameMs;
+    if(numIterations == 0){
+        numIterations = other.numIterations;
+        for(int i = 0; i < numIterations; i++){
+            iterationDepth[i] = other.iterationDepth[i];
+            iterationEndMs[i] = other.iterationEndMs[i];
+            iterationEndNodes[i] = other.iterationEndNodes[i];
+        }
+    }
+}
+
+/**
+ * Records a completed iteration of iterative deepening
+ * @param depth     Depth the iteration searched to
+ * @param elapsedMs Time since the search started
+ */
+void SearchStats::addIteration(int depth, int elapsedMs){
+    if(numIterations == MAX_ITERATIONS){
+        return;
+    }
+    iterationDepth[numIterations] = depth;
+    iterationEndMs[numIterations] = elapsedMs;
+    iterationEndNodes[numIterations] = nodes;
+    numIterations++;
+}
+
+/**
+ * Gets the depth of the last completed iteration
+ * @return Completed search depth, 0 if no iteration completed
+ */
+int SearchStats::getDepthReached() const{
+    return numIterations ? iterationDepth[numIterations - 1] : 0;
+}
+
+/**
+ * Estimates the effective branching factor from the nodes the last two
+ * iterations took, per ply between them
+ * @return Branching factor, 0 with fewer than two iterations
+ */
+double SearchStats::getBranchingFactor() const{
+    if(numIterations < 2){
+        return 0;
+    }
+    int last = numIterations - 1;
+    long long lastNodes = iterationEndNodes[last] - iterationEndNodes[last - 1];
+    long long prevNodes = iterationEndNodes[last - 1]
+                        - (last >= 2 ? iterationEndNodes[last - 2] : 0);
+    int plies = iterationDepth[last] - iterationDepth[last - 1];
+    if(prevNodes <= 0 || lastNodes <= 0 || plies <= 0){
+        return 0;
+    }
+    return pow((double)lastNodes / prevNodes, 1.0 / plies);
+}
+
+/**
+ * Writes the statistics as the fields of a JSON object, without the braces,
+ * so callers can add fields of their own around them
+ * @param out Stream to write to
+ */
+void SearchStats::writeFields(ostream& out) const{
+    out << "\"nodes\":" << nodes
+        << ",\"interior\":" << interiorNodes
+        << ",\"leaves\":" << leafNodes
+        << ",\"evals\":" << evaluations
+        << ",\"ttProbes\":" << ttProbes
+        << ",\"ttHits\":" << ttHits
+        << ",\"ttCutoffs\":" << ttCutoffs
+        << ",\"cutoffs\":" << cutoffs
+        << ",\"firstCutoffRate\":"
+        << (cutoffs ? (double)cutoffIndex[0] / cutoffs : 0)
+        << ",\"cutoffIndex\":[";
+    for(int i = 0; i < NUM_CUTOFF_BUCKETS; i++){
+        out << (i ? "," : "") << cutoffIndex[i];
+    }
+    out << "],\"depth\":" << getDepthReached()
+        << ",\"ebf\":" << getBranchingFactor()
+        << ",\"iterations\":[";
+    for(int i = 0; i < numIterations; i++){
+        out << (i ? "," : "") << "{\"depth\":" << iterationDepth[i]
+            << ",\"ms\":" << iterationEndMs[i] - (i ? iterationEndMs[i - 1] : 0)
+            << ",\"nodes\":"
+            << iterationEndNodes[i] - (i ? iterationEndNodes[i - 1] : 0) << "}";
+    }
+    out << "],\"endgameNodes\":" << endgameNodes
+        << ",\"endgameMs\":" << endgameMs;
+}
@@ -0,0 +1,64 @@
+#ifndef __SEARCHSTATS_H__
+#define __SEARCHSTATS_H__
+
+#include <iostream>
+#include <cmath>
+#include "common.hpp"
+using namespace std;
+
+// Cutoffs after this many moves share the last bucket of the histogram
+#define NUM_CUTOFF_BUCKETS 8
+// Iterations recorded per search; iterative deepening never goes deeper
+#define MAX_ITERATIONS 64
+
+/**
+ * Counts what a search did. Each search thread fills its own, with plain
+ * increments, and the counts of several threads or searches are summed
+ * afterwards, so counting is cheap enough to leave on.
+ */
+class SearchStats {
+
+public:
+    // Moves made, the count the time checks run on
+    long long nodes;
+    // Positions searched deeper, and positions where the search stopped
+    long long interiorNodes;
+    long long leafNodes;
+    // Calls to the heuristic
+    long long evaluations;
+    long long ttProbes;
+    long long ttHits;
+    // Probes whose stored bound ended the search of the position
+    long long ttCutoffs;
+    // Beta cutoffs, by the index of the move that caused them
+    long long cutoffs;
+    long long cutoffIndex[NUM_CUTOFF_BUCKETS];
+    // Nodes visited by the endgame solver, and time it spent
+    long long endgameNodes;
+    int endgameMs;
+    // Completed iterations: their depth, when they ended and the nodes by then
+    int numIterations;
+    int iterationDepth[MAX_ITERATIONS];
+    int iterationEndMs[MAX_ITERATIONS];
+    long long iterationEndNodes[MAX_ITERATIONS];
+
+    SearchStats();
+    ~SearchStats();
+    void reset();
+    void add(const SearchStats& other);
+    void addIteration(int depth, int elapsedMs);
+    int getDepthReached() const;
+    double getBranchingFactor() const;
+    void writeFields(ostream& out) const;
+
+    /**
+     * Records a beta cutoff
+     * @param index Index of the move that caused it in the node's move order
+     */
+    void addCutoff(int index){
+        cutoffs++;
+        cutoffIndex[index < NUM_CUTOFF_BUCKETS ? index : NUM_CUTOFF_BUCKETS - 1]++;
+    }
+};
+
+#endif
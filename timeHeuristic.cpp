@@ -1,7 +1,6 @@
 #include "timeHeuristic.hpp"
 
-TimeHeuristic::TimeHeuristic(const char* filename) :
-        constWeights(NUM_EACH_WEIGHTS), linearWeights(NUM_EACH_WEIGHTS) {
+TimeHeuristic::TimeHeuristic(const char* filename) {
 
     if (strcmp(filename, "weights/random.weights") == 0) {
         for (int i = 0; i < NUM_EACH_WEIGHTS; i++) {
@@ -50,61 +49,37 @@ TimeHeuristic::TimeHeuristic(const char* filename) :
 TimeHeuristic::~TimeHeuristic() {
 }
 
-VectorXd TimeHeuristic::getInputs(Board* board, bool side) {
-    VectorXd inputs(NUM_EACH_WEIGHTS);
-
-    inputs[0] = board->count(side) - board->count(!side);
-    inputs[1] = board->countMoves(side) - board->countMoves(!side);
-    inputs[2] = board->countStable(side) - board->countStable(!side);
-    inputs[3] = board->getFrontierSize(side) - board->getFrontierSize(!side);
-    inputs[4] = (board->getParity() == side) ? 1 : -1;
-
-    return inputs;
+int TimeHeuristic::getNumWeights(){
+    return NUM_TOTAL_WEIGHTS;
 }
 
-double TimeHeuristic::getScore(Board* board, bool side){
-    if (board->isDone()) {
-        int difference = board->count(side) - board->count(!side);
-        if (difference > 0) {
-            return 1;
-        }
-        else if (difference == 0) {
-            return 0;
-        }
-        else {
-            return -1;
+void TimeHeuristic::getGrad(Board* board, bool side, double* grad){
+    BoardFeatures features;
+    board->getFeatures(&features);
+    if (features.isDone) {
+        for (int i = 0; i < NUM_TOTAL_WEIGHTS; i++) {
+            grad[i] = 0;
         }
+        return;
     }
 
-    VectorXd inputs = getInputs(board, side);
-
-    double progress = (double)(board->count(BLACK) + board->count(WHITE)) / 64.0;
-    VectorXd weights = constWeights + (linearWeights * progress);
-
-    return TANH_MAX * tanh(TANH_SLOPE * weights.dot(inputs));
-}
-
+    double inputs[NUM_EACH_WEIGHTS];
+    getInputs(&features, side, inputs);
+    double progress = (double)(features.discs[BLACK] + features.discs[WHITE]) / 64.0;
+    double score = TANH_MAX * tanh(TANH_SLOPE * getSum(&features, inputs));
 
-VectorXd TimeHeuristic::getGrad(Board* board, bool side){
-    if (board->isDone()) {
-        return VectorXd::Zero(NUM_TOTAL_WEIGHTS);
+    double scalar = TANH_MAX * TANH_SLOPE * (1 - pow(tanh(TANH_SLOPE * score), 2));
+    for (int i = 0; i < NUM_EACH_WEIGHTS; i++) {
+        grad[i] = inputs[i] * scalar;
+        grad[NUM_EACH_WEIGHTS + i] = inputs[i] * progress * scalar;
     }
-
-    VectorXd inputs = getInputs(board, side);
-    double progress = (double)(board->count(BLACK) + board->count(WHITE)) / 64.0;
-
-    VectorXd preTanGrad(NUM_TOTAL_WEIGHTS);
-    preTanGrad << inputs, inputs * progress;
-
-    VectorXd weights = constWeights + (linearWeights * progress);
-    double score = TANH_MAX * tanh(TANH_SLOPE * weights.dot(inputs));
-
-    return preTanGrad * (TANH_MAX * TANH_SLOPE * (1 - pow(tanh(TANH_SLOPE * score), 2)));
 }
 
-void TimeHeuristic::updateWeights(VectorXd& deltaWeights){
-    constWeights += deltaWeights.head(NUM_EACH_WEIGHTS);
-    linearWeights += deltaWeights.tail(NUM_EACH_WEIGHTS);
+void TimeHeuristic::updateWeights(const double* deltaWeights){
+    for (int i = 0; i < NUM_EACH_WEIGHTS; i++) {
+        constWeights[i] += deltaWeights[i];
+        linearWeights[i] += deltaWeights[NUM_EACH_WEIGHTS + i];
+    }
 }
 
 void TimeHeuristic::saveWeights(const char* filename) {
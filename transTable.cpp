@@ -0,0 +1,159 @@
+#include "transTable.hpp"
+
+#define DATA_MOVE(data) ((data) & 0xff)
+#define DATA_DEPTH(data) ((char)(((data) >> 8) & 0xff))
+#define DATA_BOUND(data) ((int)(((data) >> 16) & 0x3))
+#define DATA_GENERATION(data) ((int)(((data) >> 18) & 0x3f))
+#define DATA_SCORE(data) ((uint32_t)((data) >> 32))
+
+/**
+ * Constructs an empty table
+ * @param numEntries Number of entries the table holds
+ */
+TransTable::TransTable(unsigned long long numEntries){
+    numBuckets = (numEntries + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    memory = new char[numBuckets * sizeof(Bucket) + CACHE_LINE];
+    buckets = (Bucket*)(((uintptr_t)memory + CACHE_LINE - 1)
+                                    & ~(uintptr_t)(CACHE_LINE - 1));
+    for(unsigned long long i = 0; i < numBuckets; i++){
+        new (&buckets[i]) Bucket;
+        for(int j = 0; j < BUCKET_SIZE; j++){
+            buckets[i].slots[j].check.store(0x0ULL, memory_order_relaxed);
+            buckets[i].slots[j].data.store(0x0ULL, memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+/**
+ * Deconstructs the table
+ */
+TransTable::~TransTable(){
+    delete[] memory;
+}
+
+/**
+ * Starts a new search. Entries from earlier searches are kept, but are the
+ * first to be replaced.
+ */
+void TransTable::newSearch(){
+    generation = (generation + 1) % NUM_GENERATIONS;
+}
+
+/**
+ * Packs an entry's fields into one word
+ * @param  depth      Depth the entry was searched to
+ * @param  move       Best move found
+ * @param  score      Score found
+ * @param  bound      Bound the score gives on the true score
+ * @param  generation Search the entry was stored by
+ * @return            Packed entry data
+ */
+unsigned long long TransTable::pack(int depth, Move move, float score,
+                                            int bound, int generation){
+    uint32_t scoreBits;
+    memcpy(&scoreBits, &score, sizeof(scoreBits));
+    return (unsigned long long)move.getData()
+         | ((unsigned long long)(unsigned char)depth << 8)
+         | ((unsigned long long)bound << 16)
+         | ((unsigned long long)generation << 18)
+         | ((unsigned long long)scoreBits << 32);
+}
+
+/**
+ * Unpacks an entry's fields from one word
+ * @param data  Packed entry data
+ * @param entry Entry to fill, apart from its hash
+ */
+void TransTable::unpack(unsigned long long data, TransTableEntry* entry){
+    uint32_t scoreBits = DATA_SCORE(data);
+    entry->move = Move::fromData(DATA_MOVE(data));
+    entry->depth = DATA_DEPTH(data);
+    entry->bound = DATA_BOUND(data);
+    memcpy(&entry->score, &scoreBits, sizeof(scoreBits));
+}
+
+/**
+ * Ranks an entry for replacement. Empty slots and entries from earlier
+ * searches go first, then the shallowest.
+ * @param  data Packed entry data
+ * @return      Priority to keep the entry, lowest is replaced first
+ */
+int TransTable::getPriority(unsigned long long data){
+    if(DATA_BOUND(data) == BOUND_NONE){
+        return -1000;
+    }
+    int age = (generation - DATA_GENERATION(data) + NUM_GENERATIONS) % NUM_GENERATIONS;
+    return DATA_DEPTH(data) - 8 * age;
+}
+
+/**
+ * Looks up the entry for a position
+ * @param  hash  Hash of the position
+ * @param  entry Filled with the entry if one is found
+ * @return       True if the table holds an entry for the position
+ */
+bool TransTable::probe(unsigned long long hash, TransTableEntry* entry){
+    Bucket& bucket = buckets[hash % numBuckets];
+    for(int i = 0; i < BUCKET_SIZE; i++){
+        unsigned long long data = bucket.slots[i].data.load(memory_order_relaxed);
+        unsigned long long check = bucket.slots[i].check.load(memory_order_relaxed);
+        if((check ^ data) == hash && DATA_BOUND(data) != BOUND_NONE){
+            entry->hash = hash;
+            unpack(data, entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Stores the result of a search. An entry for the same position is updated in
+ * place, unless this search already stored it much deeper. Otherwise the
+ * least valuable of the depth-preferred slots is replaced if it is no deeper
+ * than the new entry, and the always-replace slot is used if it is.
+ * @param hash  Hash of the position
+ * @param depth Depth the position was searched to
+ * @param move  Best move found
+ * @param score Score found
+ * @param bound Bound the score gives on the true score
+ */
+void TransTable::store(unsigned long long hash, int depth, Move move,
+                                            float score, int bound){
+    Bucket& bucket = buckets[hash % numBuckets];
+    unsigned long long data = pack(depth, move, score, bound, generation);
+
+    Slot* target = nullptr;
+    for(int i = 0; i < BUCKET_SIZE; i++){
+        unsigned long long old = bucket.slots[i].data.load(memory_order_relaxed);
+        unsigned long long check = bucket.slots[i].check.load(memory_order_relaxed);
+        if((check ^ old) == hash){
+            if(DATA_GENERATION(old) == generation && DATA_DEPTH(old) > depth + 2){
+                return;
+            }
+            target = &bucket.slots[i];
+            break;
+        }
+    }
+
+    if(!target){
+        int victim = 0;
+        int victimPriority = getPriority(bucket.slots[0].data.load(memory_order_relaxed));
+        for(int i = 1; i < BUCKET_SIZE - 1; i++){
+            int priority = getPriority(bucket.slots[i].data.load(memory_order_relaxed));
+            if(priority < victimPriority){
+                victim = i;
+                victimPriority = priority;
+            }
+        }
+        if(victimPriority <= depth){
+            target = &bucket.slots[victim];
+        }
+        else{
+            target = &bucket.slots[BUCKET_SIZE - 1];
+        }
+    }
+
+    target->data.store(data, memory_order_relaxed);
+    target->check.store(hash ^ data, memory_order_relaxed);
+}
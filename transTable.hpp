@@ -0,0 +1,58 @@
+#ifndef __TRANSTABLE_H__
+#define __TRANSTABLE_H__
+
+#include <atomic>
+#include <new>
+#include <cstring>
+#include <cstdint>
+#include "common.hpp"
+using namespace std;
+
+// Entries per bucket; a bucket fills one 64 byte cache line
+#define BUCKET_SIZE 4
+#define CACHE_LINE 64
+// Generations wrap around after this many searches
+#define NUM_GENERATIONS 64
+
+/**
+ * Transposition table shared by all search threads without locks. Each slot
+ * holds the entry data and the hash XORed with that data. A slot torn by two
+ * threads writing at once no longer XORs back to its hash, so a probe sees it
+ * as a miss instead of returning a mixed entry.
+ *
+ * Slots are grouped into cache-line buckets. All but the last slot of a
+ * bucket keep the deepest, most recent entries; the last slot always takes
+ * whatever the others turned away.
+ */
+class TransTable {
+
+private:
+    typedef struct {
+        atomic<unsigned long long> check;
+        atomic<unsigned long long> data;
+    } Slot;
+
+    typedef struct {
+        Slot slots[BUCKET_SIZE];
+    } Bucket;
+
+    char* memory;
+    Bucket* buckets;
+    unsigned long long numBuckets;
+    int generation;
+
+    static unsigned long long pack(int depth, Move move, float score,
+                                            int bound, int generation);
+    static void unpack(unsigned long long data, TransTableEntry* entry);
+    int getPriority(unsigned long long data);
+
+public:
+    TransTable(unsigned long long numEntries);
+    ~TransTable();
+    void newSearch();
+    bool probe(unsigned long long hash, TransTableEntry* entry);
+    void store(unsigned long long hash, int depth, Move move, float score,
+                                                                int bound);
+};
+
+#endif
@@ -1,33 +1,83 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include "player.hpp"
 using namespace std;
 
 #define DEFAULT_WEIGHTS "handmade"
+// Side first, then the rest in any order
+#define USAGE " side [weights] [threads] [ponder] [probcut] [stats=file]"
 
 int main(int argc, char *argv[]) {
     // Read in side the player is on.
-    if (argc != 2 && argc != 3)  {
-        cerr << "usage: " << argv[0] << " side [weights]" << endl;
+    if (argc < 2)  {
+        cerr << "usage: " << argv[0] << USAGE << endl;
         exit(-1);
     }
     bool side = (!strcmp(argv[1], "Black")) ? BLACK : WHITE;
 
-    char weightStr[100] = "weights/";
-    if (argc == 3) {
-        strcat(weightStr, argv[2]);
-    }
-    else {
-        strcat(weightStr, DEFAULT_WEIGHTS);
+    // Weights and threads are taken in that order from the arguments that are
+    // not named options, which may come in any order
+    const char* weights = DEFAULT_WEIGHTS;
+    int numThreads = 1;
+    // Search on the opponent's time as well
+    bool isPonderEnabled = false;
+    // Search selectively with the weights' Multi-ProbCut parameters
+    bool isProbCutEnabled = false;
+    // Search statistics go to stderr unless a file is given
+    const char* statsName = nullptr;
+    int numPositional = 0;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "ponder")) {
+            isPonderEnabled = true;
+        }
+        else if (!strcmp(argv[i], "probcut")) {
+            isProbCutEnabled = true;
+        }
+        else if (!strncmp(argv[i], "stats=", 6)) {
+            statsName = argv[i] + 6;
+        }
+        else if (numPositional == 0) {
+            weights = argv[i];
+            numPositional++;
+        }
+        else if (numPositional == 1) {
+            numThreads = max(atoi(argv[i]), 1);
+            numPositional++;
+        }
+        else {
+            cerr << "usage: " << argv[0] << USAGE << endl;
+            exit(-1);
+        }
     }
+
+    char weightStr[100] = "weights/";
+    strcat(weightStr, weights);
     strcat(weightStr, ".weights");
 
     cerr << "sudormrf: Initing as side " << (side==BLACK ? "Black" : "White") <<
-    " with heuristic weights at " << weightStr << endl;
+    " with heuristic weights at " << weightStr << " on " << numThreads <<
+    " thread(s)" << endl;
 
     // Initialize player.
-    Player *player = new Player(side, weightStr);
+    Player *player = new Player(side, weightStr, numThreads);
+    player->setPonder(isPonderEnabled);
+
+    if (isProbCutEnabled) {
+        char probCutStr[100] = "weights/";
+        strcat(probCutStr, weights);
+        strcat(probCutStr, ".probcut");
+        if (!player->setProbCut(probCutStr)) {
+            cerr << "Error opening file: " << probCutStr << endl;
+            exit(1);
+        }
+    }
+
+    if (statsName && !player->setStatsLog(statsName)) {
+        cerr << "Error opening file: " << statsName << endl;
+        exit(1);
+    }
 
     // Tell java wrapper that we are done initializing.
     cout << "Init done" << endl;
@@ -54,5 +104,6 @@ int main(int argc, char *argv[]) {
 
     }
 
+    delete player;
     return 0;
 }